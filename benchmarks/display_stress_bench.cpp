@@ -0,0 +1,200 @@
+/*******************************************************************************
+*   (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include <benchmark/benchmark.h>
+#include "utils/multisend.h"
+#include "utils/testcases.h"
+#include "tx_display.h"
+
+// Display latency of multisend transactions with up to 1202 items (600 outputs, about 61 KB of json).
+// Built with room for 8000 tokens. The first MAX_DISPLAY_ITEMS items are in the display table,
+// the rest are found by the cursor. The device review shows at most 255 items (tx_view_getNumItems),
+// so beyond that these measure the parser alone.
+// per_item is the time of each item: validate visits every item once, the sweep shows every page of
+// every item, and back shows the last item then the one before it (beyond the table, the cursor
+// does not go backward, so it seeks from the start of msgs every time).
+// BM_windowed_* compare delegations tokenized at once (arg 0) with the msgs elements tokenized again
+// when they are shown (arg 1, json_parse_windowed); tokens is the storage used.
+//
+//   display_stress_bench --benchmark_counters_tabular=true
+
+namespace {
+    constexpr uint16_t OUT_KEY_LEN = 40;
+    constexpr uint16_t OUT_VAL_LEN = 40;
+
+    struct StressTx {
+        std::string tx;
+        parser_context_t ctx;
+        uint16_t numItems;
+    };
+
+    // Returns an error description or nullptr
+    const char *prepareTx(StressTx *s, const std::string &tx, uint32_t expectedItems, bool windowed) {
+        s->tx = tx;
+
+        const parser_error_t err = windowed ? utils::parseTxWindowed(&s->ctx, s->tx, false)
+                                            : utils::parseTx(&s->ctx, s->tx, false);
+        if (err != parser_ok) {
+            return parser_getErrorDescription(err);
+        }
+
+        if (parser_getNumItems(&s->ctx, &s->numItems) != parser_ok || s->numItems != expectedItems) {
+            return "unexpected number of display items";
+        }
+
+        return nullptr;
+    }
+
+    const char *prepare(StressTx *s, uint16_t numOutputs) {
+        return prepareTx(s, utils::multisendTx(numOutputs), utils::multisendNumItems(numOutputs), false);
+    }
+
+    parser_error_t showItem(StressTx *s, uint16_t idx) {
+        char outKey[OUT_KEY_LEN];
+        char outVal[OUT_VAL_LEN];
+
+        uint8_t pageCount = 1;
+        for (uint8_t pageIdx = 0; pageIdx < pageCount; pageIdx++) {
+            CHECK_PARSER_ERR(parser_getItem(&s->ctx, idx,
+                                            outKey, sizeof(outKey),
+                                            outVal, sizeof(outVal),
+                                            pageIdx, &pageCount))
+            benchmark::DoNotOptimize(outVal);
+        }
+        return parser_ok;
+    }
+
+    void setCounters(benchmark::State &state, const StressTx &s, double itemsPerIteration) {
+        state.SetComplexityN(s.numItems);
+        state.counters["items"] = s.numItems;
+        state.counters["table_items"] = s.numItems < MAX_DISPLAY_ITEMS ? s.numItems : MAX_DISPLAY_ITEMS;
+        state.counters["per_item"] = benchmark::Counter(itemsPerIteration,
+                                                        benchmark::Counter::kIsIterationInvariantRate |
+                                                        benchmark::Counter::kInvert);
+    }
+
+    void BM_stress_validate(benchmark::State &state) {
+        StressTx s;
+        const char *error = prepare(&s, (uint16_t) state.range(0));
+        if (error != nullptr) {
+            state.SkipWithError(error);
+            return;
+        }
+
+        for (auto _ : state) {
+            // validation includes indexing the display cache, so it must be built again every time
+            parser_tx_obj.flags.cache_valid = 0;
+            if (parser_validate(&s.ctx) != parser_ok) {
+                state.SkipWithError("parser_validate failed");
+                break;
+            }
+        }
+        setCounters(state, s, s.numItems);
+    }
+
+    void BM_stress_sweep(benchmark::State &state) {
+        StressTx s;
+        const char *error = prepare(&s, (uint16_t) state.range(0));
+        if (error != nullptr) {
+            state.SkipWithError(error);
+            return;
+        }
+
+        for (auto _ : state) {
+            for (uint16_t idx = 0; idx < s.numItems; idx++) {
+                if (showItem(&s, idx) != parser_ok) {
+                    state.SkipWithError("parser_getItem failed");
+                    return;
+                }
+            }
+        }
+        setCounters(state, s, s.numItems);
+    }
+
+    void BM_stress_back(benchmark::State &state) {
+        StressTx s;
+        const char *error = prepare(&s, (uint16_t) state.range(0));
+        if (error != nullptr) {
+            state.SkipWithError(error);
+            return;
+        }
+
+        for (auto _ : state) {
+            if (showItem(&s, s.numItems - 1) != parser_ok || showItem(&s, s.numItems - 2) != parser_ok) {
+                state.SkipWithError("parser_getItem failed");
+                break;
+            }
+        }
+        setCounters(state, s, 2);
+    }
+
+    void BM_windowed_sweep(benchmark::State &state) {
+        StressTx s;
+        const auto numMsgs = (uint16_t) state.range(0);
+        const char *error = prepareTx(&s, utils::delegateTx(numMsgs), utils::delegateNumItems(numMsgs),
+                                      state.range(1) != 0);
+        if (error != nullptr) {
+            state.SkipWithError(error);
+            return;
+        }
+
+        for (auto _ : state) {
+            for (uint16_t idx = 0; idx < s.numItems; idx++) {
+                if (showItem(&s, idx) != parser_ok) {
+                    state.SkipWithError("parser_getItem failed");
+                    return;
+                }
+            }
+        }
+        setCounters(state, s, s.numItems);
+        state.counters["tokens"] = json_tokens_in_use(&parser_tx_obj.json);
+    }
+
+    void BM_windowed_back(benchmark::State &state) {
+        StressTx s;
+        const auto numMsgs = (uint16_t) state.range(0);
+        const char *error = prepareTx(&s, utils::delegateTx(numMsgs), utils::delegateNumItems(numMsgs),
+                                      state.range(1) != 0);
+        if (error != nullptr) {
+            state.SkipWithError(error);
+            return;
+        }
+
+        for (auto _ : state) {
+            if (showItem(&s, s.numItems - 1) != parser_ok || showItem(&s, s.numItems - 2) != parser_ok) {
+                state.SkipWithError("parser_getItem failed");
+                break;
+            }
+        }
+        setCounters(state, s, 2);
+        state.counters["tokens"] = json_tokens_in_use(&parser_tx_obj.json);
+    }
+
+    // 102 to 1202 items
+    void stressArgs(benchmark::internal::Benchmark *b) {
+        for (const auto n : {50, 125, 250, 500, 600}) {
+            b->Arg(n);
+        }
+        b->Complexity(benchmark::oAuto);
+    }
+
+    BENCHMARK(BM_stress_validate)->Apply(stressArgs);
+    BENCHMARK(BM_stress_sweep)->Apply(stressArgs);
+    BENCHMARK(BM_stress_back)->Apply(stressArgs);
+    BENCHMARK(BM_windowed_sweep)->ArgsProduct({{50, 100, 200}, {0, 1}});
+    BENCHMARK(BM_windowed_back)->ArgsProduct({{50, 100, 200}, {0, 1}});
+}
+
+BENCHMARK_MAIN();
@@ -0,0 +1,376 @@
+/*******************************************************************************
+*   (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <vector>
+#include "utils/multisend.h"
+#include "utils/testcases.h"
+#include "app_mode.h"
+#include "tx_display.h"
+
+// Scaling of parser_validate and the full parser_getItem sweep with the number of multisend outputs.
+// The cursor benchmarks find every item without the display table (as items beyond its capacity are found),
+// moving forward and backward with tx_display_cursor_query, and seeking each one with tx_display_find.
+// The amount benchmark shows every page of a coins list, with 1..32 coins.
+// The delegate benchmark indexes (counts and groups) a transaction with 1..100 msgs.
+// The first screen benchmarks parse and validate a transaction, then show the first page of its first item.
+//
+//   multisend_bench                       google benchmark run, N = 1..200 with fitted complexity
+//   multisend_bench --benchmark_format=csv > scaling.csv
+//   multisend_bench --guard               time vs N table + growth exponent check (used by ctest)
+
+namespace {
+    constexpr uint16_t OUT_KEY_LEN = 40;
+    constexpr uint16_t OUT_VAL_LEN = 40;
+
+    // Growth exponent ceilings for the guard (time ~ N^k, fitted on a log-log scale).
+    // Linear code measures ~1.0, quadratic ~2.0 and cubic ~3.0.
+    // Items are looked up in the display table, so the sweep is linear (~N^1.0 over GUARD_N).
+    // Indexing the root fields walks msgs once, so validate is linear too (~N^0.9).
+    // These ceilings only stop it from getting worse; lower them as the pipeline improves.
+    constexpr double MAX_VALIDATE_EXPONENT = 1.5;
+    constexpr double MAX_SWEEP_EXPONENT = 1.5;
+    // Moving forward, the cursor resumes from the previous item instead of seeking it (~N^1.0)
+    constexpr double MAX_CURSOR_EXPONENT = 1.5;
+
+    const std::vector<int64_t> SCALING_N = {1, 2, 5, 10, 25, 50, 100, 150, 200};
+    const std::vector<uint16_t> GUARD_N = {8, 16, 32, 64};
+
+    struct MultisendTx {
+        std::string tx;
+        parser_context_t ctx;
+        uint16_t numItems;
+    };
+
+    // Returns an error description or nullptr
+    const char *prepare(MultisendTx *m, uint16_t numOutputs) {
+        m->tx = utils::multisendTx(numOutputs);
+
+        const parser_error_t err = utils::parseTx(&m->ctx, m->tx, false);
+        if (err != parser_ok) {
+            return parser_getErrorDescription(err);
+        }
+
+        if (parser_getNumItems(&m->ctx, &m->numItems) != parser_ok) {
+            return "parser_getNumItems failed";
+        }
+
+        if (m->numItems != utils::multisendNumItems(numOutputs)) {
+            return "unexpected number of display items";
+        }
+
+        return nullptr;
+    }
+
+    parser_error_t validate(MultisendTx *m) {
+        // validation includes indexing the display cache, so it must be built again every time
+        parser_tx_obj.flags.cache_valid = 0;
+        return parser_validate(&m->ctx);
+    }
+
+    parser_error_t sweep(MultisendTx *m) {
+        char outKey[OUT_KEY_LEN];
+        char outVal[OUT_VAL_LEN];
+
+        for (uint16_t idx = 0; idx < m->numItems; idx++) {
+            uint8_t pageCount = 1;
+            for (uint8_t pageIdx = 0; pageIdx < pageCount; pageIdx++) {
+                CHECK_PARSER_ERR(parser_getItem(&m->ctx, idx,
+                                                outKey, sizeof(outKey),
+                                                outVal, sizeof(outVal),
+                                                pageIdx, &pageCount))
+                benchmark::DoNotOptimize(outVal);
+            }
+        }
+        return parser_ok;
+    }
+
+    typedef parser_error_t (*item_search_fn)(uint16_t, char *, uint16_t, uint16_t *, key_id_e *);
+
+    parser_error_t searchItems(MultisendTx *m, item_search_fn search, bool backward) {
+        char outKey[OUT_KEY_LEN];
+        uint16_t token;
+        key_id_e keyId;
+
+        for (uint16_t i = 0; i < m->numItems; i++) {
+            const uint16_t idx = backward ? m->numItems - 1 - i : i;
+            CHECK_PARSER_ERR(search(idx, outKey, sizeof(outKey), &token, &keyId))
+            benchmark::DoNotOptimize(token);
+        }
+        return parser_ok;
+    }
+
+    void BM_multisend_search(benchmark::State &state, item_search_fn search, bool backward) {
+        MultisendTx m;
+        const char *error = prepare(&m, (uint16_t) state.range(0));
+        if (error != nullptr) {
+            state.SkipWithError(error);
+            return;
+        }
+
+        for (auto _ : state) {
+            if (searchItems(&m, search, backward) != parser_ok) {
+                state.SkipWithError("item search failed");
+                break;
+            }
+        }
+        state.SetComplexityN(state.range(0));
+        state.counters["items"] = m.numItems;
+    }
+
+    void BM_multisend_validate(benchmark::State &state) {
+        MultisendTx m;
+        const char *error = prepare(&m, (uint16_t) state.range(0));
+        if (error != nullptr) {
+            state.SkipWithError(error);
+            return;
+        }
+
+        for (auto _ : state) {
+            if (validate(&m) != parser_ok) {
+                state.SkipWithError("parser_validate failed");
+                break;
+            }
+        }
+        state.SetComplexityN(state.range(0));
+        state.SetBytesProcessed((int64_t) state.iterations() * (int64_t) m.tx.size());
+        state.counters["items"] = m.numItems;
+    }
+
+    void BM_multisend_sweep(benchmark::State &state) {
+        MultisendTx m;
+        const char *error = prepare(&m, (uint16_t) state.range(0));
+        if (error != nullptr) {
+            state.SkipWithError(error);
+            return;
+        }
+
+        for (auto _ : state) {
+            if (sweep(&m) != parser_ok) {
+                state.SkipWithError("parser_getItem failed");
+                break;
+            }
+        }
+        state.SetComplexityN(state.range(0));
+        state.SetBytesProcessed((int64_t) state.iterations() * (int64_t) m.tx.size());
+        state.counters["items"] = m.numItems;
+    }
+
+    // Indexing of a transaction with N delegate msgs (type and delegator are grouped)
+    void BM_delegate_index(benchmark::State &state) {
+        const uint16_t numMsgs = (uint16_t) state.range(0);
+        const std::string tx = utils::delegateTx(numMsgs);
+        parser_context_t ctx;
+        if (utils::parseTx(&ctx, tx, false) != parser_ok) {
+            state.SkipWithError("parser_parse failed");
+            return;
+        }
+
+        uint16_t numItems = 0;
+        for (auto _ : state) {
+            parser_tx_obj.flags.cache_valid = 0;
+            if (parser_getNumItems(&ctx, &numItems) != parser_ok) {
+                state.SkipWithError("parser_getNumItems failed");
+                break;
+            }
+        }
+        if (numItems != utils::delegateNumItems(numMsgs)) {
+            state.SkipWithError("unexpected number of items");
+        }
+        state.SetComplexityN(state.range(0));
+        state.counters["items"] = numItems;
+    }
+
+    // All the pages of the input coins of a multisend with numDenoms coins per input/output
+    void BM_multisend_amount_pages(benchmark::State &state) {
+        const std::string tx = utils::multisendTx(1, (uint16_t) state.range(0));
+        parser_context_t ctx;
+        if (utils::parseTx(&ctx, tx, false) != parser_ok) {
+            state.SkipWithError("parser_parse failed");
+            return;
+        }
+
+        char outKey[OUT_KEY_LEN];
+        char outVal[OUT_VAL_LEN];
+        // 0: input address, 1: input coins
+        const uint16_t coinsIdx = 1;
+
+        for (auto _ : state) {
+            uint8_t pageCount = 1;
+            for (uint8_t pageIdx = 0; pageIdx < pageCount; pageIdx++) {
+                if (parser_getItem(&ctx, coinsIdx, outKey, sizeof(outKey), outVal, sizeof(outVal),
+                                   pageIdx, &pageCount) != parser_ok) {
+                    state.SkipWithError("parser_getItem failed");
+                    break;
+                }
+                benchmark::DoNotOptimize(outVal);
+            }
+        }
+        state.SetComplexityN(state.range(0));
+    }
+
+    std::string multisendOutputsTx(uint16_t numOutputs) {
+        return utils::multisendTx(numOutputs);
+    }
+
+    // Time until the first item can be shown, from the complete transaction
+    void BM_first_screen(benchmark::State &state, std::string (*makeTx)(uint16_t)) {
+        const std::string tx = makeTx((uint16_t) state.range(0));
+        parser_context_t ctx;
+        char outKey[OUT_KEY_LEN];
+        char outVal[OUT_VAL_LEN];
+        uint16_t numItems = 0;
+
+        for (auto _ : state) {
+            uint8_t pageCount = 0;
+            if (utils::parseTx(&ctx, tx, false) != parser_ok ||
+                parser_getNumItems(&ctx, &numItems) != parser_ok ||
+                parser_getItem(&ctx, 0, outKey, sizeof(outKey), outVal, sizeof(outVal), 0, &pageCount) != parser_ok) {
+                state.SkipWithError("first screen failed");
+                break;
+            }
+            benchmark::DoNotOptimize(outVal);
+        }
+        state.SetComplexityN(state.range(0));
+        state.SetBytesProcessed((int64_t) state.iterations() * (int64_t) tx.size());
+        state.counters["items"] = numItems;
+    }
+
+    void scalingArgs(benchmark::internal::Benchmark *b) {
+        for (const auto n : SCALING_N) {
+            b->Arg(n);
+        }
+        b->Complexity(benchmark::oAuto);
+    }
+
+    // Delegate transactions with more msgs need more than HOST_MAX_NUMBER_OF_TOKENS
+    void firstScreenArgs(benchmark::internal::Benchmark *b) {
+        for (const auto n : {1, 10, 25, 50, 100}) {
+            b->Arg(n);
+        }
+        b->Complexity(benchmark::oAuto);
+    }
+
+    BENCHMARK(BM_multisend_validate)->Apply(scalingArgs);
+    BENCHMARK(BM_multisend_sweep)->Apply(scalingArgs);
+    BENCHMARK_CAPTURE(BM_multisend_search, cursor_forward, tx_display_cursor_query, false)->Apply(scalingArgs);
+    BENCHMARK_CAPTURE(BM_multisend_search, cursor_backward, tx_display_cursor_query, true)->Apply(scalingArgs);
+    BENCHMARK_CAPTURE(BM_multisend_search, seek_forward, tx_display_find, false)->Apply(scalingArgs);
+    BENCHMARK(BM_delegate_index)->Arg(1)->Arg(10)->Arg(25)->Arg(50)->Arg(100)->Complexity(benchmark::oAuto);
+    BENCHMARK(BM_multisend_amount_pages)->RangeMultiplier(2)->Range(1, 32)->Complexity(benchmark::oAuto);
+    BENCHMARK_CAPTURE(BM_first_screen, multisend, multisendOutputsTx)->Apply(firstScreenArgs);
+    BENCHMARK_CAPTURE(BM_first_screen, delegate, utils::delegateTx)->Apply(firstScreenArgs);
+
+    ///////////////////////////////////////////////
+
+    // Best of several runs, in seconds
+    double timeIt(const std::function<parser_error_t()> &fn, bool *ok) {
+        double best = 1e9;
+        for (int rep = 0; rep < 5; rep++) {
+            // repeat fast calls so that timer resolution does not matter
+            uint32_t loops = 0;
+            const auto start = std::chrono::steady_clock::now();
+            std::chrono::duration<double> elapsed{};
+            do {
+                if (fn() != parser_ok) {
+                    *ok = false;
+                    return 0;
+                }
+                loops++;
+                elapsed = std::chrono::steady_clock::now() - start;
+            } while (elapsed.count() < 0.005);
+            best = std::min(best, elapsed.count() / loops);
+        }
+        return best;
+    }
+
+    // Least squares slope of log(t) vs log(N)
+    double growthExponent(const std::vector<double> &n, const std::vector<double> &t) {
+        double sx = 0, sy = 0, sxx = 0, sxy = 0;
+        const double k = (double) n.size();
+        for (size_t i = 0; i < n.size(); i++) {
+            const double x = std::log(n[i]);
+            const double y = std::log(t[i]);
+            sx += x;
+            sy += y;
+            sxx += x * x;
+            sxy += x * y;
+        }
+        return (k * sxy - sx * sy) / (k * sxx - sx * sx);
+    }
+
+    int runGuard() {
+        std::vector<double> ns, tValidate, tSweep, tCursor;
+        bool ok = true;
+
+        printf("%8s %8s %16s %16s %16s\n", "N", "items", "validate [us]", "sweep [us]", "cursor [us]");
+        for (const auto n : GUARD_N) {
+            MultisendTx m;
+            const char *error = prepare(&m, n);
+            if (error != nullptr) {
+                printf("N=%d: %s\n", n, error);
+                return 1;
+            }
+
+            const double v = timeIt([&m] { return validate(&m); }, &ok);
+            const double s = timeIt([&m] { return sweep(&m); }, &ok);
+            const double c = timeIt([&m] { return searchItems(&m, tx_display_cursor_query, false); }, &ok);
+            if (!ok) {
+                printf("N=%d: parser error\n", n);
+                return 1;
+            }
+
+            ns.push_back(n);
+            tValidate.push_back(v);
+            tSweep.push_back(s);
+            tCursor.push_back(c);
+            printf("%8d %8d %16.1f %16.1f %16.1f\n", n, m.numItems, v * 1e6, s * 1e6, c * 1e6);
+        }
+
+        const double kValidate = growthExponent(ns, tValidate);
+        const double kSweep = growthExponent(ns, tSweep);
+        const double kCursor = growthExponent(ns, tCursor);
+        printf("validate ~ N^%.2f (max %.2f)\n", kValidate, MAX_VALIDATE_EXPONENT);
+        printf("sweep    ~ N^%.2f (max %.2f)\n", kSweep, MAX_SWEEP_EXPONENT);
+        printf("cursor   ~ N^%.2f (max %.2f)\n", kCursor, MAX_CURSOR_EXPONENT);
+
+        if (kValidate > MAX_VALIDATE_EXPONENT || kSweep > MAX_SWEEP_EXPONENT || kCursor > MAX_CURSOR_EXPONENT) {
+            printf("FAILED: growth is above the allowed exponent\n");
+            return 1;
+        }
+        return 0;
+    }
+}
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--guard") == 0) {
+            return runGuard();
+        }
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
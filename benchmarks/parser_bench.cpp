@@ -0,0 +1,250 @@
+/*******************************************************************************
+*   (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <vector>
+#include "utils/multisend.h"
+#include "utils/testcases.h"
+#include "app_mode.h"
+#include "tx_parser.h"
+
+// Host benchmarks for the parser entry points over the transactions in tests/testcases
+// Every benchmark reports time per call (ns/op) and bytes/s of raw transaction json.
+//
+//   parser_bench --benchmark_filter=sweep/multisend
+//   parser_bench --benchmark_filter=last_chunk
+//   parser_bench --benchmark_filter=key_lookup
+
+namespace {
+    // Value sizes used by the review screens
+    constexpr uint16_t OUT_KEY_LEN = 40;
+    constexpr uint16_t OUT_VAL_LEN = 40;
+
+    // APDU payload size used by the clients
+    constexpr size_t CHUNK_SIZE = 250;
+
+    bool prepare(benchmark::State &state, parser_context_t *ctx, const std::string &tx, bool expert) {
+        const parser_error_t err = utils::parseTx(ctx, tx, expert);
+        if (err != parser_ok) {
+            state.SkipWithError(parser_getErrorDescription(err));
+            return false;
+        }
+        return true;
+    }
+
+    void finish(benchmark::State &state, const std::string &tx) {
+        state.SetBytesProcessed((int64_t) state.iterations() * (int64_t) tx.size());
+        state.counters["tx_bytes"] = (double) tx.size();
+    }
+
+    void BM_parser_parse(benchmark::State &state, const std::string &tx, bool expert) {
+        app_mode_set_expert(expert);
+        parser_context_t ctx;
+
+        for (auto _ : state) {
+            const parser_error_t err = parser_parse(&ctx, (const uint8_t *) tx.c_str(), tx.size());
+            if (err != parser_ok) {
+                state.SkipWithError(parser_getErrorDescription(err));
+                break;
+            }
+        }
+        finish(state, tx);
+    }
+
+    void BM_parser_validate(benchmark::State &state, const std::string &tx, bool expert) {
+        parser_context_t ctx;
+        if (!prepare(state, &ctx, tx, expert)) {
+            return;
+        }
+
+        for (auto _ : state) {
+            // validation includes indexing the display cache, so it must be built again every time
+            parser_tx_obj.flags.cache_valid = 0;
+            const parser_error_t err = parser_validate(&ctx);
+            if (err != parser_ok) {
+                state.SkipWithError(parser_getErrorDescription(err));
+                break;
+            }
+        }
+        finish(state, tx);
+    }
+
+    void BM_parser_getNumItems(benchmark::State &state, const std::string &tx, bool expert) {
+        parser_context_t ctx;
+        if (!prepare(state, &ctx, tx, expert)) {
+            return;
+        }
+
+        uint16_t numItems = 0;
+        for (auto _ : state) {
+            parser_getNumItems(&ctx, &numItems);
+            benchmark::DoNotOptimize(numItems);
+        }
+        state.counters["items"] = numItems;
+        finish(state, tx);
+    }
+
+    void BM_parser_getItem_sweep(benchmark::State &state, const std::string &tx, bool expert) {
+        parser_context_t ctx;
+        if (!prepare(state, &ctx, tx, expert)) {
+            return;
+        }
+
+        uint16_t numItems = 0;
+        parser_getNumItems(&ctx, &numItems);
+
+        char outKey[OUT_KEY_LEN];
+        char outVal[OUT_VAL_LEN];
+        uint32_t pages = 0;
+
+        for (auto _ : state) {
+            pages = 0;
+            for (uint16_t idx = 0; idx < numItems; idx++) {
+                uint8_t pageCount = 1;
+                for (uint8_t pageIdx = 0; pageIdx < pageCount; pageIdx++) {
+                    const parser_error_t err = parser_getItem(&ctx, idx,
+                                                              outKey, sizeof(outKey),
+                                                              outVal, sizeof(outVal),
+                                                              pageIdx, &pageCount);
+                    if (err != parser_ok) {
+                        state.SkipWithError(parser_getErrorDescription(err));
+                        return;
+                    }
+                    benchmark::DoNotOptimize(outVal);
+                    pages++;
+                }
+            }
+        }
+        state.counters["items"] = numItems;
+        state.counters["pages"] = pages;
+        finish(state, tx);
+    }
+
+    // Time from the last APDU chunk to the first review item: parse what is left, validate and show item 0.
+    // streamed=false tokenizes the full tx after the last chunk (as before), streamed=true tokenizes
+    // every chunk on arrival, so only the last one is on the critical path.
+    // review=false stops after parsing, which is the part that streaming changes.
+    void BM_last_chunk(benchmark::State &state, const std::string &tx, bool streamed, bool review) {
+        app_mode_set_expert(false);
+        parser_context_t ctx;
+        const auto data = (const uint8_t *) tx.c_str();
+        const size_t lastChunkStart = tx.size() > CHUNK_SIZE ? ((tx.size() - 1) / CHUNK_SIZE) * CHUNK_SIZE : 0;
+
+        char outKey[OUT_KEY_LEN];
+        char outVal[OUT_VAL_LEN];
+
+        for (auto _ : state) {
+            parser_parse_init(&ctx);
+            if (streamed) {
+                for (size_t received = CHUNK_SIZE; received <= lastChunkStart; received += CHUNK_SIZE) {
+                    parser_parse_chunk(&ctx, data, received);
+                }
+            }
+
+            const auto start = std::chrono::steady_clock::now();
+            if (streamed) {
+                parser_parse_chunk(&ctx, data, tx.size());
+            }
+            parser_error_t err = parser_parse_finish(&ctx, data, tx.size());
+            if (err == parser_ok && review) {
+                err = parser_validate(&ctx);
+            }
+            uint8_t pageCount = 0;
+            if (err == parser_ok && review) {
+                err = parser_getItem(&ctx, 0, outKey, sizeof(outKey), outVal, sizeof(outVal), 0, &pageCount);
+            }
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+            if (err != parser_ok) {
+                state.SkipWithError(parser_getErrorDescription(err));
+                break;
+            }
+            benchmark::DoNotOptimize(outVal);
+            state.SetIterationTime(elapsed.count());
+        }
+        finish(state, tx);
+        state.counters["chunks"] = (double) ((tx.size() + CHUNK_SIZE - 1) / CHUNK_SIZE);
+    }
+
+    // Known path lookup of every string token of the tx, as a root key and as a key of a msg
+    void BM_key_lookup(benchmark::State &state, const std::string &tx) {
+        parser_context_t ctx;
+        if (!prepare(state, &ctx, tx, false)) {
+            return;
+        }
+
+        std::vector<uint16_t> strings;
+        for (uint16_t i = 0; i < parser_tx_obj.json.numberOfTokens; i++) {
+            if (parser_tx_obj.json.tokens[i].type == JSMN_STRING) {
+                strings.push_back(i);
+            }
+        }
+
+        for (auto _ : state) {
+            for (const uint16_t token : strings) {
+                benchmark::DoNotOptimize(tx_key_child(key_root, token));
+                benchmark::DoNotOptimize(tx_key_child(key_msgs, token));
+            }
+        }
+        state.SetItemsProcessed((int64_t) state.iterations() * (int64_t) strings.size() * 2);
+        finish(state, tx);
+    }
+
+    void registerLastChunk(const std::string &name, const std::string &tx) {
+        for (const bool review : {false, true}) {
+            for (const bool streamed : {false, true}) {
+                const std::string benchName = std::string(review ? "last_chunk/" : "last_chunk_parse/") +
+                                              (streamed ? "streamed/" : "full/") + name;
+                benchmark::RegisterBenchmark(benchName.c_str(), BM_last_chunk, tx, streamed, review)->UseManualTime();
+            }
+        }
+    }
+
+    void registerCorpus() {
+        for (const auto &name : utils::testcaseNames()) {
+            const std::string tx = utils::loadTestcase(name);
+
+            for (const bool expert : {false, true}) {
+                const std::string suffix = name + (expert ? "/expert" : "");
+
+                benchmark::RegisterBenchmark(("parse/" + suffix).c_str(), BM_parser_parse, tx, expert);
+                benchmark::RegisterBenchmark(("validate/" + suffix).c_str(), BM_parser_validate, tx, expert);
+                benchmark::RegisterBenchmark(("getNumItems/" + suffix).c_str(), BM_parser_getNumItems, tx, expert);
+                benchmark::RegisterBenchmark(("sweep/" + suffix).c_str(), BM_parser_getItem_sweep, tx, expert);
+            }
+            benchmark::RegisterBenchmark(("key_lookup/" + name).c_str(), BM_key_lookup, tx);
+            registerLastChunk(name, tx);
+        }
+
+        // multi-chunk transactions
+        for (const uint16_t numOutputs : {25, 100}) {
+            registerLastChunk("multisend_N" + std::to_string(numOutputs), utils::multisendTx(numOutputs));
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+
+    registerCorpus();
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,69 @@
+/*******************************************************************************
+*   (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include <benchmark/benchmark.h>
+#include "utils/multisend.h"
+#include "utils/testcases.h"
+#include "json/json_parser.h"
+
+// Tokenization alone (json_parse), in bytes/s of transaction json. Long memos, addresses and denoms are
+// string scanning; tokenizer_bench_byte_scan is the same benchmark with strings scanned one byte at a time.
+//
+//   tokenizer_bench --benchmark_filter=memo
+//   tokenizer_bench_byte_scan --benchmark_filter=memo
+
+namespace {
+    parsed_json_t json;
+    jsmntok_t tokens[MAX_NUMBER_OF_TOKENS];
+
+    void BM_tokenize(benchmark::State &state, const std::string &tx) {
+        for (auto _ : state) {
+            const parser_error_t err = json_parse(&json, tokens, MAX_NUMBER_OF_TOKENS, tx.c_str(), tx.size());
+            if (err != parser_ok) {
+                state.SkipWithError(parser_getErrorDescription(err));
+                break;
+            }
+            benchmark::DoNotOptimize(tokens);
+        }
+
+        state.SetBytesProcessed((int64_t) state.iterations() * (int64_t) tx.size());
+        state.counters["tx_bytes"] = (double) tx.size();
+        state.counters["tokens"] = json.numberOfTokens;
+    }
+
+    void registerTokenizers() {
+        for (const auto &name : utils::testcaseNames()) {
+            benchmark::RegisterBenchmark(("tokenize/" + name).c_str(), BM_tokenize, utils::loadTestcase(name));
+        }
+        for (const size_t memoLen : {64, 256, 1024, 4096, 16384}) {
+            benchmark::RegisterBenchmark(("tokenize/memo_" + std::to_string(memoLen)).c_str(),
+                                         BM_tokenize, utils::memoTx(memoLen));
+        }
+        benchmark::RegisterBenchmark("tokenize/multisend_N100", BM_tokenize, utils::multisendTx(100));
+    }
+}
+
+int main(int argc, char **argv) {
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+
+    registerTokenizers();
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
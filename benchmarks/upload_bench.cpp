@@ -0,0 +1,125 @@
+/*******************************************************************************
+*   (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include "utils/multisend.h"
+#include "utils/testcases.h"
+#include "tx_buffer.h"
+#include "zxmacros.h"
+
+// Transaction upload as tx_append and tx_parse do it, counting the flash writes.
+// flash_* counters are for the tx buffer arena, legacy_flash_* for the previous buffering
+// (TX_BUFFER_RAM_SIZE bytes of RAM, then the whole transaction goes to flash).
+// arena_peak is the peak usage of the tx buffer arena once the tx is validated and all its items shown.
+//
+//   upload_bench --benchmark_counters_tabular=true
+
+namespace {
+    // APDU payload size used by the clients
+    constexpr size_t CHUNK_SIZE = 250;
+
+    // aligned as N_appdata, so that page counts match the device
+    alignas(64) uint8_t flash[65536];
+
+    void addPageWrite(nvm_stats_t *stats, size_t offset, size_t length) {
+        stats->writes++;
+        stats->bytes += length;
+        stats->pages += (uint32_t) ((offset + length - 1) / NVM_PAGE_SIZE - offset / NVM_PAGE_SIZE + 1);
+    }
+
+    // RAM until a chunk does not fit, then the RAM content and every following chunk are written to flash
+    nvm_stats_t legacyFlashWrites(size_t txSize) {
+        nvm_stats_t stats = {};
+        bool inFlash = false;
+        for (size_t offset = 0; offset < txSize; offset += CHUNK_SIZE) {
+            const size_t length = std::min(CHUNK_SIZE, txSize - offset);
+            if (!inFlash && offset + length > TX_BUFFER_RAM_SIZE) {
+                inFlash = true;
+                if (offset > 0) {
+                    addPageWrite(&stats, 0, offset);
+                }
+            }
+            if (inFlash) {
+                addPageWrite(&stats, offset, length);
+            }
+        }
+        return stats;
+    }
+
+    void BM_upload(benchmark::State &state, const std::string &tx) {
+        tx_buffer_init(flash, sizeof(flash));
+        const uint32_t numChunks = (uint32_t) ((tx.size() + CHUNK_SIZE - 1) / CHUNK_SIZE);
+        // as announced by the packet count of the APDUs
+        const uint32_t maxLength = numChunks * 255;
+
+        parser_context_t ctx;
+        for (auto _ : state) {
+            nvm_stats = {};
+            const parser_error_t err = utils::uploadTx(&ctx, tx, false, CHUNK_SIZE, maxLength);
+            if (err != parser_ok) {
+                state.SkipWithError(parser_getErrorDescription(err));
+                break;
+            }
+        }
+
+        const nvm_stats_t legacy = legacyFlashWrites(tx.size());
+        state.SetBytesProcessed((int64_t) state.iterations() * (int64_t) tx.size());
+        state.counters["tx_bytes"] = (double) tx.size();
+        state.counters["in_flash"] = tx_buffer_in_flash() ? 1 : 0;
+        state.counters["flash_bytes"] = nvm_stats.bytes;
+        state.counters["flash_pages"] = nvm_stats.pages;
+        state.counters["legacy_flash_bytes"] = legacy.bytes;
+        state.counters["legacy_flash_pages"] = legacy.pages;
+
+        // outside the timed loop, the arena used by the review
+        tx_buffer_watermark_reset();
+        if (utils::uploadTx(&ctx, tx, false, CHUNK_SIZE, maxLength) == parser_ok && parser_validate(&ctx) == parser_ok) {
+            utils::dumpUI(&ctx, 40, 40);
+        }
+
+        state.counters["arena_peak"] = (double) tx_buffer_watermark();
+
+        tx_buffer_init(nullptr, 0);
+    }
+
+    void registerUploads() {
+        for (const auto &name : utils::testcaseNames()) {
+            benchmark::RegisterBenchmark(("upload/" + name).c_str(), BM_upload, utils::loadTestcase(name));
+        }
+        for (const uint16_t numOutputs : {25, 50, 100, 150, 200}) {
+            benchmark::RegisterBenchmark(("upload/multisend_N" + std::to_string(numOutputs)).c_str(),
+                                         BM_upload, utils::multisendTx(numOutputs));
+        }
+        // up to the longest memo that can be shown (255 pages of 39 characters)
+        for (const size_t memoLen : {2048, 4096, 8192, 9945}) {
+            benchmark::RegisterBenchmark(("upload/memo_" + std::to_string(memoLen)).c_str(),
+                                         BM_upload, utils::memoTx(memoLen));
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+
+    registerUploads();
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
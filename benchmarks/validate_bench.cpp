@@ -0,0 +1,175 @@
+/*******************************************************************************
+*   (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "tx_validate.h"
+
+// tx_validate on transactions with one large msgs object (N sorted keys of a given length)
+// compared with the previous implementation (separate whitespace and key order passes, keys copied
+// into 256-byte stack buffers before comparing).
+//
+//   validate_bench --benchmark_filter=/256/
+
+namespace {
+    parsed_json_t json;
+    jsmntok_t tokens[MAX_NUMBER_OF_TOKENS];
+
+    // Previous implementation, kept here as the reference
+    namespace reference {
+        const char whitespaces[] = {0x20, 0x0c, 0x0a, 0x0d, 0x09, 0x0b};
+
+        int8_t is_space(char c) {
+            for (char w : whitespaces) {
+                if (w == c) {
+                    return 1;
+                }
+            }
+            return 0;
+        }
+
+        int8_t contains_whitespace(const parsed_json_t *j) {
+            int start = 0;
+            const int last_element_index = j->tokens[0].end;
+
+            for (uint32_t i = 1; i < j->numberOfTokens; i++) {
+                if (j->tokens[i].type != JSMN_UNDEFINED) {
+                    const int end = j->tokens[i].start;
+                    for (int k = start; k < end; k++) {
+                        if (is_space(j->buffer[k]) == 1) {
+                            return 1;
+                        }
+                    }
+                    start = j->tokens[i].end + 1;
+                } else {
+                    return 0;
+                }
+            }
+            while (start < last_element_index && j->buffer[start] != '\0') {
+                if (is_space(j->buffer[start])) {
+                    return 1;
+                }
+                start++;
+            }
+            return 0;
+        }
+
+        int8_t is_sorted(uint16_t first_index, uint16_t second_index, const parsed_json_t *j) {
+            char first[256];
+            char second[256];
+            memset(first, 0, sizeof first);
+            memset(second, 0, sizeof second);
+
+            size_t size = j->tokens[first_index].end - j->tokens[first_index].start;
+            if (size >= sizeof(first)) {
+                return 0;
+            }
+            strncpy(first, j->buffer + j->tokens[first_index].start, size);
+            first[size] = '\0';
+
+            size = j->tokens[second_index].end - j->tokens[second_index].start;
+            if (size >= sizeof(second)) {
+                return 0;
+            }
+            strncpy(second, j->buffer + j->tokens[second_index].start, size);
+            second[size] = '\0';
+
+            return strcmp(first, second) <= 0 ? 1 : 0;
+        }
+
+        int8_t dictionaries_sorted(const parsed_json_t *j) {
+            for (uint16_t i = 0; i < j->numberOfTokens; i++) {
+                if (j->tokens[i].type == JSMN_OBJECT) {
+                    const uint16_t end = json_next_sibling(j, i);
+                    uint16_t prev = json_first_child(j, i);
+                    if (prev + 1 >= end) {
+                        continue;
+                    }
+                    for (uint16_t next = json_next_sibling(j, prev + 1);
+                         next + 1 < end;
+                         next = json_next_sibling(j, next + 1)) {
+                        if (!is_sorted(prev, next, j)) {
+                            return 0;
+                        }
+                        prev = next;
+                    }
+                }
+            }
+            return 1;
+        }
+
+        parser_error_t validate(const parsed_json_t *j) {
+            if (contains_whitespace(j) == 1) {
+                return parser_json_contains_whitespace;
+            }
+            if (dictionaries_sorted(j) != 1) {
+                return parser_json_is_not_sorted;
+            }
+            return parser_ok;
+        }
+    }
+
+    std::string largeObjectTx(uint16_t numKeys, uint16_t keyLen) {
+        std::string msg = "{";
+        char key[16];
+        for (uint16_t i = 0; i < numKeys; i++) {
+            snprintf(key, sizeof(key), "%05u", i);
+            if (i > 0) {
+                msg += ",";
+            }
+            // common prefix so that comparisons need to go through the key
+            msg += "\"" + std::string(keyLen - 5, 'k') + key + "\":\"value\"";
+        }
+        msg += "}";
+
+        return R"({"account_number":"1","chain_id":"Binance-Chain-Tigris","data":"DATA","memo":"MEMO","msgs":[)" +
+               msg + R"(],"sequence":"2","source":"1"})";
+    }
+
+    void BM_validate(benchmark::State &state, bool fused) {
+        const std::string tx = largeObjectTx((uint16_t) state.range(0), (uint16_t) state.range(1));
+        if (json_parse(&json, tokens, MAX_NUMBER_OF_TOKENS, tx.c_str(), tx.size()) != parser_ok) {
+            state.SkipWithError("json_parse failed");
+            return;
+        }
+
+        tx_root_slots_t slots;
+        for (auto _ : state) {
+            const parser_error_t err = fused ? tx_validate(&json, &slots) : reference::validate(&json);
+            if (err != parser_ok) {
+                state.SkipWithError("validation failed");
+                break;
+            }
+        }
+        state.SetBytesProcessed((int64_t) state.iterations() * (int64_t) tx.size());
+        state.counters["tokens"] = json.numberOfTokens;
+    }
+
+    void objectArgs(benchmark::internal::Benchmark *b) {
+        for (const int64_t numKeys : {16, 64, 256, 400}) {
+            for (const int64_t keyLen : {8, 64}) {
+                b->Args({numKeys, keyLen});
+            }
+        }
+        b->ArgNames({"keys", "key_len"});
+    }
+
+    BENCHMARK_CAPTURE(BM_validate, fused, true)->Apply(objectArgs);
+    BENCHMARK_CAPTURE(BM_validate, reference, false)->Apply(objectArgs);
+}
+
+BENCHMARK_MAIN();
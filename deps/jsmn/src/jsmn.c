@@ -1,5 +1,112 @@
 #include "jsmn.h"
 
+/**
+ * Character classes, in the order tested by the primitive scanner
+ */
+enum jsmnclass {
+	JSMN_CLASS_OTHER = 0,	/* continues a primitive (starts one in non-strict mode) */
+	JSMN_CLASS_PRIMITIVE,	/* starts a number, true, false or null */
+	JSMN_CLASS_OPEN,	/* { [ */
+	JSMN_CLASS_QUOTE,
+	/* from here, the classes that end a primitive */
+	JSMN_CLASS_COLON,
+	JSMN_CLASS_SPACE,
+	JSMN_CLASS_COMMA,
+	JSMN_CLASS_CLOSE,	/* } ] */
+	JSMN_CLASS_INVALID	/* control characters and non-ASCII bytes outside strings */
+};
+
+#ifdef JSMN_STRICT
+/* In strict mode primitive must be followed by "," or "}" or "]" */
+#define JSMN_CLASS_PRIMITIVE_END JSMN_CLASS_SPACE
+#else
+#define JSMN_CLASS_PRIMITIVE_END JSMN_CLASS_COLON
+#endif
+
+#define OT JSMN_CLASS_OTHER
+#define PR JSMN_CLASS_PRIMITIVE
+#define OP JSMN_CLASS_OPEN
+#define QU JSMN_CLASS_QUOTE
+#define CO JSMN_CLASS_COLON
+#define SP JSMN_CLASS_SPACE
+#define CM JSMN_CLASS_COMMA
+#define CL JSMN_CLASS_CLOSE
+#define IN JSMN_CLASS_INVALID
+static const unsigned char jsmn_class[256] = {
+	IN, IN, IN, IN, IN, IN, IN, IN, IN, SP, SP, IN, IN, SP, IN, IN, /* 00 */
+	IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, /* 10 */
+	SP, OT, QU, OT, OT, OT, OT, OT, OT, OT, OT, OT, CM, PR, OT, OT, /* 20 */
+	PR, PR, PR, PR, PR, PR, PR, PR, PR, PR, CO, OT, OT, OT, OT, OT, /* 30 */
+	OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, /* 40 */
+	OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OP, OT, CL, OT, OT, /* 50 */
+	OT, OT, OT, OT, OT, OT, PR, OT, OT, OT, OT, OT, OT, OT, PR, OT, /* 60 */
+	OT, OT, OT, OT, PR, OT, OT, OT, OT, OT, OT, OP, OT, CL, OT, IN, /* 70 */
+	IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, /* 80 */
+	IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, /* 90 */
+	IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, /* A0 */
+	IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, /* B0 */
+	IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, /* C0 */
+	IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, /* D0 */
+	IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, /* E0 */
+	IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, /* F0 */
+};
+#undef OT
+#undef PR
+#undef OP
+#undef QU
+#undef CO
+#undef SP
+#undef CM
+#undef CL
+#undef IN
+
+#define JSMN_CLASS_OF(c) jsmn_class[(unsigned char) (c)]
+
+#if !defined(JSMN_NO_SWAR) && defined(__GNUC__)
+#define JSMN_SWAR
+#endif
+
+#ifdef JSMN_SWAR
+/* Machine word, 4 bytes on Cortex-M and 8 on 64-bit hosts. Only read at aligned addresses */
+typedef size_t __attribute__((may_alias)) jsmn_word_t;
+
+#define JSMN_WORD_ONES (((jsmn_word_t) -1) / 0xFF)
+#define JSMN_WORD_HIGHS (JSMN_WORD_ONES * 0x80)
+/* Non-zero if any byte of x is below n (n <= 0x80) */
+#define JSMN_WORD_HAS_LESS(x, n) (((x) - JSMN_WORD_ONES * (n)) & ~(x) & JSMN_WORD_HIGHS)
+#define JSMN_WORD_HAS_BYTE(x, b) JSMN_WORD_HAS_LESS((x) ^ (JSMN_WORD_ONES * (b)), 1)
+
+/* Bytes that end a run of plain string characters: quote, backslash and control characters (incl. '\0') */
+static int jsmn_is_plain(char c) {
+	return c != '\"' && c != '\\' && (unsigned char) c >= 0x20;
+}
+
+/**
+ * Skips plain string characters a word at a time.
+ * Returns the position of the first byte that is not plain, or len.
+ */
+static size_t jsmn_skip_plain(const char *js, size_t pos, size_t len) {
+	/* up to a word boundary */
+	for (; pos < len && ((size_t) (js + pos) % sizeof(jsmn_word_t)) != 0; pos++) {
+		if (!jsmn_is_plain(js[pos])) {
+			return pos;
+		}
+	}
+
+	for (; pos + sizeof(jsmn_word_t) <= len; pos += sizeof(jsmn_word_t)) {
+		const jsmn_word_t w = *(const jsmn_word_t *) (js + pos);
+		if (JSMN_WORD_HAS_BYTE(w, '\"') | JSMN_WORD_HAS_BYTE(w, '\\') | JSMN_WORD_HAS_LESS(w, 0x20)) {
+			break;
+		}
+	}
+
+	/* the byte found in the word, or the last bytes */
+	for (; pos < len && jsmn_is_plain(js[pos]); pos++) {
+	}
+	return pos;
+}
+#endif
+
 /**
  * Allocates a fresh unused token from the token pull.
  */
@@ -10,8 +117,13 @@ static jsmntok_t *jsmn_alloc_token(jsmn_parser *parser,
 		return NULL;
 	}
 	tok = &tokens[parser->toknext++];
-	tok->start = tok->end = -1;
+	tok->start = tok->end = JSMN_POS_UNSET;
+#ifdef JSMN_PACKED
+	/* Containers are linked again when they are closed */
+	tok->next = parser->toknext;
+#else
 	tok->size = 0;
+#endif
 #ifdef JSMN_PARENT_LINKS
 	tok->parent = -1;
 #endif
@@ -22,11 +134,13 @@ static jsmntok_t *jsmn_alloc_token(jsmn_parser *parser,
  * Fills token type and boundaries.
  */
 static void jsmn_fill_token(jsmntok_t *token, jsmntype_t type,
-                            short int start, short int end) {
+                            jsmnpos_t start, jsmnpos_t end) {
 	token->type = type;
 	token->start = start;
 	token->end = end;
+#ifndef JSMN_PACKED
 	token->size = 0;
+#endif
 }
 
 /**
@@ -35,23 +149,18 @@ static void jsmn_fill_token(jsmntok_t *token, jsmntype_t type,
 static int jsmn_parse_primitive(jsmn_parser *parser, const char *js,
 		size_t len, jsmntok_t *tokens, size_t num_tokens) {
 	jsmntok_t *token;
-	short int start;
+	jsmnpos_t start;
 
 	start = parser->pos;
 
 	for (; parser->pos < len && js[parser->pos] != '\0'; parser->pos++) {
-		switch (js[parser->pos]) {
-#ifndef JSMN_STRICT
-			/* In strict mode primitive must be followed by "," or "}" or "]" */
-			case ':':
-#endif
-			case '\t' : case '\r' : case '\n' : case ' ' :
-			case ','  : case ']'  : case '}' :
-				goto found;
-		}
-		if (js[parser->pos] < 32 || js[parser->pos] >= 127) {
-			parser->pos = start;
-			return JSMN_ERROR_INVAL;
+		const unsigned char char_class = JSMN_CLASS_OF(js[parser->pos]);
+		if (char_class >= JSMN_CLASS_PRIMITIVE_END) {
+			if (char_class == JSMN_CLASS_INVALID) {
+				parser->pos = start;
+				return JSMN_ERROR_INVAL;
+			}
+			goto found;
 		}
 	}
 #ifdef JSMN_STRICT
@@ -85,13 +194,20 @@ static int jsmn_parse_string(jsmn_parser *parser, const char *js,
 		size_t len, jsmntok_t *tokens, size_t num_tokens) {
 	jsmntok_t *token;
 
-	short int start = parser->pos;
+	jsmnpos_t start = parser->pos;
 
 	parser->pos++;
 
 	/* Skip starting quote */
 	for (; parser->pos < len && js[parser->pos] != '\0'; parser->pos++) {
-		char c = js[parser->pos];
+		char c;
+#ifdef JSMN_SWAR
+		parser->pos = jsmn_skip_plain(js, parser->pos, len);
+		if (parser->pos >= len || js[parser->pos] == '\0') {
+			break;
+		}
+#endif
+		c = js[parser->pos];
 
 		/* Quote: end of string */
 		if (c == '\"') {
@@ -155,13 +271,19 @@ int jsmn_parse(jsmn_parser *parser, const char *js, size_t len,
 	jsmntok_t *token;
 	short int count = parser->toknext;
 
+#ifdef JSMN_PACKED
+	if (num_tokens > JSMN_PACKED_MAX_TOKENS) {
+		num_tokens = JSMN_PACKED_MAX_TOKENS;
+	}
+#endif
+
 	for (; parser->pos < len && js[parser->pos] != '\0'; parser->pos++) {
 		char c;
 		jsmntype_t type;
 
 		c = js[parser->pos];
-		switch (c) {
-			case '{': case '[':
+		switch (JSMN_CLASS_OF(c)) {
+			case JSMN_CLASS_OPEN:
 				count++;
 				if (tokens == NULL) {
 					break;
@@ -170,7 +292,9 @@ int jsmn_parse(jsmn_parser *parser, const char *js, size_t len,
 				if (token == NULL)
 					return JSMN_ERROR_NOMEM;
 				if (parser->toksuper != -1) {
+#ifndef JSMN_PACKED
 					tokens[parser->toksuper].size++;
+#endif
 #ifdef JSMN_PARENT_LINKS
 					token->parent = parser->toksuper;
 #endif
@@ -179,7 +303,7 @@ int jsmn_parse(jsmn_parser *parser, const char *js, size_t len,
 				token->start = parser->pos;
 				parser->toksuper = parser->toknext - 1;
 				break;
-			case '}': case ']':
+			case JSMN_CLASS_CLOSE:
 				if (tokens == NULL)
 					break;
 				type = (c == '}' ? JSMN_OBJECT : JSMN_ARRAY);
@@ -189,7 +313,7 @@ int jsmn_parse(jsmn_parser *parser, const char *js, size_t len,
 				}
 				token = &tokens[parser->toknext - 1];
 				for (;;) {
-					if (token->start != -1 && token->end == -1) {
+					if (token->start != JSMN_POS_UNSET && token->end == JSMN_POS_UNSET) {
 						if (token->type != type) {
 							return JSMN_ERROR_INVAL;
 						}
@@ -208,12 +332,15 @@ int jsmn_parse(jsmn_parser *parser, const char *js, size_t len,
 #else
 				for (i = parser->toknext - 1; i >= 0; i--) {
 					token = &tokens[i];
-					if (token->start != -1 && token->end == -1) {
+					if (token->start != JSMN_POS_UNSET && token->end == JSMN_POS_UNSET) {
 						if (token->type != type) {
 							return JSMN_ERROR_INVAL;
 						}
 						parser->toksuper = -1;
 						token->end = parser->pos + 1;
+#ifdef JSMN_PACKED
+						token->next = parser->toknext;
+#endif
 						break;
 					}
 				}
@@ -221,26 +348,28 @@ int jsmn_parse(jsmn_parser *parser, const char *js, size_t len,
 				if (i == -1) return JSMN_ERROR_INVAL;
 				for (; i >= 0; i--) {
 					token = &tokens[i];
-					if (token->start != -1 && token->end == -1) {
+					if (token->start != JSMN_POS_UNSET && token->end == JSMN_POS_UNSET) {
 						parser->toksuper = i;
 						break;
 					}
 				}
 #endif
 				break;
-			case '\"':
+			case JSMN_CLASS_QUOTE:
 				r = jsmn_parse_string(parser, js, len, tokens, num_tokens);
 				if (r < 0) return r;
 				count++;
+#ifndef JSMN_PACKED
 				if (parser->toksuper != -1 && tokens != NULL)
 					tokens[parser->toksuper].size++;
+#endif
 				break;
-			case '\t' : case '\r' : case '\n' : case ' ':
+			case JSMN_CLASS_SPACE:
 				break;
-			case ':':
+			case JSMN_CLASS_COLON:
 				parser->toksuper = parser->toknext - 1;
 				break;
-			case ',':
+			case JSMN_CLASS_COMMA:
 				if (tokens != NULL && parser->toksuper != -1 &&
 						tokens[parser->toksuper].type != JSMN_ARRAY &&
 						tokens[parser->toksuper].type != JSMN_OBJECT) {
@@ -249,7 +378,7 @@ int jsmn_parse(jsmn_parser *parser, const char *js, size_t len,
 #else
 					for (i = parser->toknext - 1; i >= 0; i--) {
 						if (tokens[i].type == JSMN_ARRAY || tokens[i].type == JSMN_OBJECT) {
-							if (tokens[i].start != -1 && tokens[i].end == -1) {
+							if (tokens[i].start != JSMN_POS_UNSET && tokens[i].end == JSMN_POS_UNSET) {
 								parser->toksuper = i;
 								break;
 							}
@@ -258,11 +387,11 @@ int jsmn_parse(jsmn_parser *parser, const char *js, size_t len,
 #endif
 				}
 				break;
+			case JSMN_CLASS_INVALID:
+				return JSMN_ERROR_INVAL;
 #ifdef JSMN_STRICT
 			/* In strict mode primitives are: numbers and booleans */
-			case '-': case '0': case '1' : case '2': case '3' : case '4':
-			case '5': case '6': case '7' : case '8': case '9':
-			case 't': case 'f': case 'n' :
+			case JSMN_CLASS_PRIMITIVE:
 				/* And they must not be keys of the object */
 				if (tokens != NULL && parser->toksuper != -1) {
 					jsmntok_t *t = &tokens[parser->toksuper];
@@ -273,18 +402,20 @@ int jsmn_parse(jsmn_parser *parser, const char *js, size_t len,
 				}
 #else
 			/* In non-strict mode every unquoted value is a primitive */
-			default:
+			case JSMN_CLASS_PRIMITIVE: case JSMN_CLASS_OTHER:
 #endif
 				r = jsmn_parse_primitive(parser, js, len, tokens, num_tokens);
 				if (r < 0) return r;
 				count++;
+#ifndef JSMN_PACKED
 				if (parser->toksuper != -1 && tokens != NULL)
 					tokens[parser->toksuper].size++;
+#endif
 				break;
 
 #ifdef JSMN_STRICT
 			/* Unexpected char in strict mode */
-			default:
+			case JSMN_CLASS_OTHER:
 				return JSMN_ERROR_INVAL;
 #endif
 		}
@@ -293,7 +424,7 @@ int jsmn_parse(jsmn_parser *parser, const char *js, size_t len,
 	if (tokens != NULL) {
 		for (i = parser->toknext - 1; i >= 0; i--) {
 			/* Unmatched opened object or array */
-			if (tokens[i].start != -1 && tokens[i].end == -1) {
+			if (tokens[i].start != JSMN_POS_UNSET && tokens[i].end == JSMN_POS_UNSET) {
 				return JSMN_ERROR_PART;
 			}
 		}
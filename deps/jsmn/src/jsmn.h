@@ -31,6 +31,36 @@ enum jsmnerr {
 	JSMN_ERROR_PART = -3
 };
 
+#ifdef JSMN_PACKED
+#if defined(JSMN_STRICT) || defined(JSMN_PARENT_LINKS)
+#error "JSMN_PACKED cannot be combined with JSMN_STRICT or JSMN_PARENT_LINKS"
+#endif
+
+/* Position in JSON data string. Unset positions are JSMN_POS_UNSET */
+typedef unsigned short int jsmnpos_t;
+#define JSMN_POS_UNSET ((jsmnpos_t) 0xFFFF)
+
+/* Largest token index that fits in the packed next field */
+#define JSMN_PACKED_MAX_TOKENS 0x1FFF
+
+/**
+ * Packed JSON token description (6 bytes).
+ * start	start position in JSON data string
+ * end		end position in JSON data string
+ * type		type (object, array, string etc.)
+ * next		index of the next token at the same level
+ *		(i.e. the first token after this token and its children)
+ */
+typedef struct {
+	jsmnpos_t start;
+	jsmnpos_t end;
+	unsigned short int type : 3;
+	unsigned short int next : 13;
+} jsmntok_t;
+#else
+typedef short int jsmnpos_t;
+#define JSMN_POS_UNSET ((jsmnpos_t) -1)
+
 /**
  * JSON token description.
  * type		type (object, array, string etc.)
@@ -46,6 +76,7 @@ typedef struct {
 	short int parent;
 #endif
 } jsmntok_t;
+#endif
 
 /**
  * JSON parser. Contains an array of token blocks available. Also stores
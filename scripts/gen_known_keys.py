@@ -0,0 +1,377 @@
+#!/usr/bin/env python3
+#*******************************************************************************
+#*   (c) 2018 - 2023 Zondax AG
+#*
+#*  Licensed under the Apache License, Version 2.0 (the "License");
+#*  you may not use this file except in compliance with the License.
+#*  You may obtain a copy of the License at
+#*
+#*      http://www.apache.org/licenses/LICENSE-2.0
+#*
+#*  Unless required by applicable law or agreed to in writing, software
+#*  distributed under the License is distributed on an "AS IS" BASIS,
+#*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#*  See the License for the specific language governing permissions and
+#*  limitations under the License.
+#********************************************************************************
+"""Generates src/known_keys.h/.c from src/known_keys.spec.
+
+Known keys are found with a minimal perfect hash over (parent id, key name) (hash and displace):
+
+    h      = FNV-1a of the parent id and the name bytes, starting from SEED
+    bucket = (h >> 16) * NUM_BUCKETS >> 16
+    slot   = ((h ^ displacement[bucket]) * GOLDEN >> 16) * NUM_KEYS >> 16
+
+Key ids follow the order of the spec, the slot table maps every slot to its key id.
+Names, labels and values are stored once in a single string pool and referenced by 16 bit offsets.
+
+    gen_known_keys.py            write the sources
+    gen_known_keys.py --check    fail if the sources are not up to date (used by ctest)
+"""
+
+import argparse
+import os
+import shlex
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SPEC = os.path.join(ROOT, "src", "known_keys.spec")
+OUT_H = os.path.join(ROOT, "src", "known_keys.h")
+OUT_C = os.path.join(ROOT, "src", "known_keys.c")
+
+MASK32 = 0xFFFFFFFF
+FNV_PRIME = 16777619
+FNV_OFFSET = 2166136261
+GOLDEN = 0x9E3779B1
+
+KEY_UNKNOWN = 0
+KEY_ROOT = 1
+FIRST_KEY_ID = 2
+
+LICENSE = """/*******************************************************************************
+*   (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+// Generated by scripts/gen_known_keys.py from src/known_keys.spec. Do not edit.
+"""
+
+
+class Key:
+    def __init__(self, path, label):
+        self.path = path
+        self.label = label
+        self.values = []
+        self.parent_path, _, self.name = path.rpartition("/")
+        self.id = None
+        self.parent_id = KEY_ROOT
+
+    @property
+    def enum_name(self):
+        return "key_" + self.path.replace("/", "_")
+
+
+def fail(msg):
+    sys.exit("known_keys.spec: " + msg)
+
+
+def read_spec(path):
+    keys = {}
+    with open(path) as f:
+        for line_no, line in enumerate(f, 1):
+            words = shlex.split(line, comments=True)
+            if not words:
+                continue
+
+            where = "line %d: " % line_no
+            if words[0] == "key" and len(words) in (2, 3):
+                key = Key(words[1], words[2] if len(words) == 3 else None)
+                if key.path in keys:
+                    fail(where + "duplicated key " + key.path)
+                if key.parent_path and key.parent_path not in keys:
+                    fail(where + "parent of %s is not listed before it" % key.path)
+                keys[key.path] = key
+            elif words[0] == "value" and len(words) == 4:
+                if words[1] not in keys:
+                    fail(where + "unknown key " + words[1])
+                keys[words[1]].values.append((words[2], words[3]))
+            else:
+                fail(where + "expected 'key <path> [label]' or 'value <path> <value> <label>'")
+
+    keys = list(keys.values())
+    for i, key in enumerate(keys):
+        key.id = FIRST_KEY_ID + i
+        if key.parent_path:
+            key.parent_id = next(k.id for k in keys if k.path == key.parent_path)
+    return keys
+
+
+def key_hash(seed, parent, name):
+    h = seed
+    for c in bytes([parent]) + name.encode():
+        h = ((h ^ c) * FNV_PRIME) & MASK32
+    return h
+
+
+def bucket_of(h, num_buckets):
+    return ((h >> 16) * num_buckets) >> 16
+
+
+def slot_of(h, displacement, num_keys):
+    x = ((h ^ displacement) * GOLDEN) & MASK32
+    return ((x >> 16) * num_keys) >> 16
+
+
+def build_hash(keys):
+    """Hash and displace: buckets are placed from the largest, each with the first displacement that
+    sends all its keys to free slots. Returns the seed, the displacements and the key of every slot"""
+    num_keys = len(keys)
+    num_buckets = max(1, (num_keys + 1) // 2)
+
+    for attempt in range(256):
+        seed = (FNV_OFFSET + attempt * GOLDEN) & MASK32
+        hashes = {k.path: key_hash(seed, k.parent_id, k.name) for k in keys}
+
+        buckets = [[] for _ in range(num_buckets)]
+        for k in keys:
+            buckets[bucket_of(hashes[k.path], num_buckets)].append(k)
+
+        displacements = [0] * num_buckets
+        slots = [None] * num_keys
+        placed = True
+        for bucket in sorted(range(num_buckets), key=lambda b: -len(buckets[b])):
+            if not buckets[bucket]:
+                continue
+            for d in range(1 << 16):
+                wanted = [slot_of(hashes[k.path], d, num_keys) for k in buckets[bucket]]
+                if len(set(wanted)) == len(wanted) and all(slots[w] is None for w in wanted):
+                    displacements[bucket] = d
+                    for k, w in zip(buckets[bucket], wanted):
+                        slots[w] = k
+                    break
+            else:
+                placed = False
+                break
+
+        if placed:
+            return seed, displacements, slots
+
+    fail("no perfect hash found, change the hash parameters")
+
+
+class Pool:
+    def __init__(self):
+        # offset 0 is the empty string, used for "no label"
+        self.strings = [""]
+        self.offsets = {"": 0}
+        self.size = 1
+
+    def add(self, s):
+        if s not in self.offsets:
+            self.offsets[s] = self.size
+            self.strings.append(s)
+            self.size += len(s.encode()) + 1
+        if self.offsets[s] > 0xFFFF:
+            fail("string pool is too large")
+        return self.offsets[s]
+
+
+def c_string(s):
+    return '"' + s.replace("\\", "\\\\").replace('"', '\\"') + '\\0"'
+
+
+def generate(keys):
+    seed, displacements, slots = build_hash(keys)
+    displacement_size = 1 if max(displacements) <= 0xFF else 2
+
+    pool = Pool()
+    values = []
+    rows = []
+    for k in keys:
+        if len(k.name.encode()) > 0xFF:
+            fail("key name is too long: " + k.name)
+        first_value = len(values)
+        for value, label in k.values:
+            values.append((pool.add(value), pool.add(label), k.path, value))
+        rows.append((k, pool.add(k.name), pool.add(k.label) if k.label else 0, first_value))
+
+    sizes = {
+        "pool": pool.size,
+        "keys": 8 * len(rows),
+        "values": 4 * len(values),
+        "hash": displacement_size * len(displacements) + len(slots),
+    }
+    total = sum(sizes.values())
+
+    h = [LICENSE, "#pragma once\n",
+         "#include <stdint.h>\n",
+         "#ifdef __cplusplus",
+         'extern "C" {',
+         "#endif\n",
+         "// Known key paths (see known_keys.spec)",
+         "typedef enum {",
+         "    key_unknown = %d," % KEY_UNKNOWN,
+         "    // the tx object",
+         "    key_root = %d," % KEY_ROOT]
+    for k in keys:
+        h.append("    %s," % k.enum_name)
+    h += ["",
+          "    NUM_KEY_IDS",
+          "} key_id_e;\n",
+          "/// Known path of the key name below the known path parent",
+          "/// \\param parent",
+          "/// \\param name key name (it does not need to be terminated)",
+          "/// \\param name_len",
+          "/// \\return key id, key_unknown if there is no such path",
+          "key_id_e known_key_find(key_id_e parent, const char *name, uint16_t name_len);\n",
+          "/// Label of a known path",
+          "/// \\param key_id",
+          "/// \\return label, or NULL if the path is shown as it is",
+          "const char *known_key_label(key_id_e key_id);\n",
+          "/// Label of a value of a known path",
+          "/// \\param key_id",
+          "/// \\param value terminated value",
+          "/// \\return label, or NULL if the value is shown as it is",
+          "const char *known_key_value_label(key_id_e key_id, const char *value);\n",
+          "#ifdef __cplusplus",
+          "}",
+          "#endif",
+          ""]
+
+    c = [LICENSE,
+         "// Minimal perfect hash over (parent id, key name) of the known keys, see scripts/gen_known_keys.py.",
+         "// Keys are stored by id, strings are packed in a single pool.",
+         "// Flash: %d bytes (pool %d, keys %d, values %d, hash %d)" % (
+             total, sizes["pool"], sizes["keys"], sizes["values"], sizes["hash"]),
+         '#include "known_keys.h"',
+         '#include "zxmacros.h"\n',
+         "#define KNOWN_KEYS_FIRST_ID %d" % FIRST_KEY_ID,
+         "#define KNOWN_KEYS_COUNT %d" % len(keys),
+         "#define KNOWN_KEYS_BUCKETS %d" % len(displacements),
+         "#define KNOWN_KEYS_SEED 0x%08Xu" % seed,
+         "#define KNOWN_KEYS_FNV_PRIME %du" % FNV_PRIME,
+         "#define KNOWN_KEYS_GOLDEN 0x%08Xu\n" % GOLDEN,
+         "typedef struct {",
+         "    uint8_t parent;",
+         "    uint8_t name_len;",
+         "    // values in known_values",
+         "    uint8_t first_value;",
+         "    uint8_t num_values;",
+         "    // offsets in known_keys_pool, label is 0 when there is none",
+         "    uint16_t name;",
+         "    uint16_t label;",
+         "} known_key_t;\n",
+         "typedef struct {",
+         "    uint16_t value;",
+         "    uint16_t label;",
+         "} known_value_t;\n",
+         "static const char known_keys_pool[] ="]
+    c += ["        " + c_string(s) for s in pool.strings[:-1]]
+    c += ["        " + c_string(pool.strings[-1])[:-3] + '";\n']
+
+    c.append("static const uint%d_t known_keys_displacement[KNOWN_KEYS_BUCKETS] = {" % (8 * displacement_size))
+    for i in range(0, len(displacements), 8):
+        c.append("        " + ", ".join("%d" % d for d in displacements[i:i + 8]) + ",")
+    c.append("};\n")
+
+    c.append("static const uint8_t known_keys_slot_id[KNOWN_KEYS_COUNT] = {")
+    for i in range(0, len(slots), 8):
+        c.append("        " + ", ".join(s.enum_name for s in slots[i:i + 8]) + ",")
+    c.append("};\n")
+
+    c.append("// by key id")
+    c.append("static const known_key_t known_keys[KNOWN_KEYS_COUNT] = {")
+    for k, name, label, first_value in rows:
+        c.append("        {%d, %d, %d, %d, %d, %d},    // %s" % (
+            k.parent_id, len(k.name.encode()), first_value, len(k.values), name, label, k.path))
+    c.append("};\n")
+
+    c.append("static const known_value_t known_values[] = {")
+    for value, label, path, raw in values:
+        c.append("        {%d, %d},    // %s = %s" % (value, label, path, raw))
+    if not values:
+        c.append("        {0, 0},")
+    c.append("};\n")
+
+    c += ["__Z_INLINE uint32_t known_keys_hash(uint8_t parent, const char *name, uint16_t name_len) {",
+          "    uint32_t h = (KNOWN_KEYS_SEED ^ parent) * KNOWN_KEYS_FNV_PRIME;",
+          "    for (uint16_t i = 0; i < name_len; i++) {",
+          "        h = (h ^ (uint8_t) name[i]) * KNOWN_KEYS_FNV_PRIME;",
+          "    }",
+          "    return h;",
+          "}\n",
+          "key_id_e known_key_find(key_id_e parent, const char *name, uint16_t name_len) {",
+          "    const uint32_t h = known_keys_hash((uint8_t) parent, name, name_len);",
+          "    const uint32_t bucket = ((h >> 16) * KNOWN_KEYS_BUCKETS) >> 16;",
+          "    const uint32_t x = (h ^ known_keys_displacement[bucket]) * KNOWN_KEYS_GOLDEN;",
+          "    const uint32_t slot = ((x >> 16) * KNOWN_KEYS_COUNT) >> 16;",
+          "",
+          "    // every name hashes to some slot, so the key there must be checked",
+          "    const uint8_t key_id = known_keys_slot_id[slot];",
+          "    const known_key_t *key = &known_keys[key_id - KNOWN_KEYS_FIRST_ID];",
+          "    if (key->parent != parent || key->name_len != name_len ||",
+          "        MEMCMP(known_keys_pool + key->name, name, name_len) != 0) {",
+          "        return key_unknown;",
+          "    }",
+          "    return (key_id_e) key_id;",
+          "}\n",
+          "const char *known_key_label(key_id_e key_id) {",
+          "    if (key_id < KNOWN_KEYS_FIRST_ID || key_id >= NUM_KEY_IDS) {",
+          "        return NULL;",
+          "    }",
+          "    const known_key_t *key = &known_keys[key_id - KNOWN_KEYS_FIRST_ID];",
+          "    return key->label != 0 ? known_keys_pool + key->label : NULL;",
+          "}\n",
+          "const char *known_key_value_label(key_id_e key_id, const char *value) {",
+          "    if (key_id < KNOWN_KEYS_FIRST_ID || key_id >= NUM_KEY_IDS) {",
+          "        return NULL;",
+          "    }",
+          "    const known_key_t *key = &known_keys[key_id - KNOWN_KEYS_FIRST_ID];",
+          "    for (uint8_t i = 0; i < key->num_values; i++) {",
+          "        const known_value_t *known = &known_values[key->first_value + i];",
+          "        if (strcmp(value, known_keys_pool + known->value) == 0) {",
+          "            return known_keys_pool + known->label;",
+          "        }",
+          "    }",
+          "    return NULL;",
+          "}",
+          ""]
+
+    return "\n".join(h), "\n".join(c), total
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--check", action="store_true", help="check that the generated sources are up to date")
+    args = parser.parse_args()
+
+    header, source, total = generate(read_spec(SPEC))
+
+    outputs = [(OUT_H, header), (OUT_C, source)]
+    if args.check:
+        stale = []
+        for path, content in outputs:
+            if not os.path.exists(path) or open(path).read() != content:
+                stale.append(os.path.relpath(path, ROOT))
+        if stale:
+            sys.exit("out of date, run scripts/gen_known_keys.py: " + ", ".join(stale))
+        return
+
+    for path, content in outputs:
+        with open(path, "w") as f:
+            f.write(content)
+    print("known keys: %d bytes of tables" % total)
+
+
+if __name__ == "__main__":
+    main()
@@ -101,7 +101,9 @@ bool process_chunk(uint32_t rx, bool getBip32) {
 
     if (packageIndex == 1) {
         tx_initialize();
-        tx_reset();
+        // every packet carries at most a full APDU of data
+        tx_reset(packageCount * (IO_APDU_BUFFER_SIZE - OFFSET_DATA));
+        crypto_txHashInit();
         if (getBip32) {
             extractHDPath(rx, offset + 1);
             // must be the last bip32 the user "saw" for signing to work.
@@ -116,6 +118,8 @@ bool process_chunk(uint32_t rx, bool getBip32) {
     if (tx_append(&(G_io_apdu_buffer[offset]), rx - offset) != rx - offset) {
         THROW(APDU_CODE_OUTPUT_BUFFER_TOO_SMALL);
     }
+    // hash while receiving, signing only has to finalize the digest
+    crypto_txHashUpdate(&(G_io_apdu_buffer[offset]), rx - offset);
 
     return packageIndex == packageCount;
 }
@@ -123,10 +127,11 @@ bool process_chunk(uint32_t rx, bool getBip32) {
 void tx_accept_sign() {
     int result = 0;
     size_t length = (size_t) IO_APDU_BUFFER_SIZE;
+    uint8_t message_digest[CX_SHA256_SIZE];
 
+    crypto_txHashFinal(message_digest);
     result = sign_secp256k1(
-            tx_get_buffer(),
-            tx_get_buffer_length(),
+            message_digest,
             G_io_apdu_buffer,
             &length);
     
@@ -240,7 +245,7 @@ __Z_INLINE void handleSignSecp256K1(volatile uint32_t *flags, volatile uint32_t
     }
 
     CHECK_APP_CANARY()
-    view_review_init(tx_getItem, tx_getNumItems, tx_accept_sign);
+    view_review_init(tx_view_getItem, tx_view_getNumItems, tx_accept_sign);
     view_review_show(REVIEW_TXN);
     *flags |= IO_ASYNCH_REPLY;
 }
@@ -291,10 +296,7 @@ void handleApdu(volatile uint32_t *flags, volatile uint32_t *tx, uint32_t rx) {
                     if (process_chunk(rx, false)) {
                         uint8_t message_digest[CX_SHA256_SIZE];
 
-                        cx_hash_sha256(tx_get_buffer(),
-                                       tx_get_buffer_length(),
-                                       message_digest,
-                                       CX_SHA256_SIZE);
+                        crypto_txHashFinal(message_digest);
 
                         memmove(G_io_apdu_buffer, message_digest, CX_SHA256_SIZE);
                         *tx += 32;
@@ -324,10 +326,11 @@ void handleApdu(volatile uint32_t *flags, volatile uint32_t *tx, uint32_t rx) {
                 case INS_SIGN_SECP256K1_TEST: {
                     if (process_chunk(rx, false)) {
                         size_t length = (size_t) IO_APDU_BUFFER_SIZE;
+                        uint8_t message_digest[CX_SHA256_SIZE];
 
                         // Skip UI and validation
-                        sign_secp256k1(tx_get_buffer(),
-                                       tx_get_buffer_length(),
+                        crypto_txHashFinal(message_digest);
+                        sign_secp256k1(message_digest,
                                        G_io_apdu_buffer,
                                        &length);
 
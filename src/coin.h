@@ -67,6 +67,7 @@ typedef enum {
 #define COIN_DEFAULT_CHAINID                "Binance-Chain-Tigris"
 
 #define COIN_DEFAULT_DENOM_FACTOR           8
+#define COIN_DEFAULT_DENOM_UNIT             100000000ull    // 10^COIN_DEFAULT_DENOM_FACTOR
 #define COIN_DEFAULT_DENOM_TRIMMING         8
 
 // Coin denoms may be up to 128 characters long
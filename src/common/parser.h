@@ -29,15 +29,33 @@ parser_error_t parser_parse(parser_context_t *ctx,
                             const uint8_t *data,
                             size_t dataLen);
 
+//// starts parsing a tx buffer that is received in chunks
+void parser_parse_init(parser_context_t *ctx);
+
+//// tokenizes the data received so far (data must hold all previous chunks)
+parser_error_t parser_parse_chunk(parser_context_t *ctx,
+                                  const uint8_t *data,
+                                  size_t dataLen);
+
+//// completes parsing of a tx buffer started with parser_parse_init
+parser_error_t parser_parse_finish(parser_context_t *ctx,
+                                   const uint8_t *data,
+                                   size_t dataLen);
+
+//// parses a tx buffer with more tokens than fit, the msgs elements are tokenized again when they are shown
+parser_error_t parser_parse_windowed(parser_context_t *ctx,
+                                     const uint8_t *data,
+                                     size_t dataLen);
+
 //// verifies tx fields
 parser_error_t parser_validate(const parser_context_t *ctx);
 
 //// returns the number of items in the current parsing context
-parser_error_t parser_getNumItems(const parser_context_t *ctx, uint8_t *num_items);
+parser_error_t parser_getNumItems(const parser_context_t *ctx, uint16_t *num_items);
 
 // retrieves a readable output for each field / page
 parser_error_t parser_getItem(const parser_context_t *ctx,
-                              uint8_t displayIdx,
+                              uint16_t displayIdx,
                               char *outKey, uint16_t outKeyLen,
                               char *outVal, uint16_t outValLen,
                               uint8_t pageIdx, uint8_t *pageCount);
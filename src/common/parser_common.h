@@ -64,6 +64,9 @@ typedef enum {
     parser_json_missing_source,
     parser_json_missing_data,
     parser_json_unexpected_error,
+    // Display limits
+    parser_display_too_many_items,
+    parser_display_too_many_pages,
 } parser_error_t;
 
 typedef struct {
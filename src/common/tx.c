@@ -16,23 +16,21 @@
 
 #include "tx.h"
 #include "apdu_codes.h"
-#include "buffering.h"
 #include "parser.h"
+#include "tx_buffer.h"
 #include <string.h>
 #include "zxmacros.h"
 
 #if !defined(TARGET_NANOS)
-#define RAM_BUFFER_SIZE 8192
 #define FLASH_BUFFER_SIZE 16384
 #else
-#define RAM_BUFFER_SIZE 256
 #define FLASH_BUFFER_SIZE 8192
 #endif
 
-// Ram
-uint8_t ram_buffer[RAM_BUFFER_SIZE];
+// The zxlib view counts the review items in a uint8_t
+#define TX_VIEW_MAX_ITEMS UINT8_MAX
 
-// Flash
+// Flash, only for transactions that do not fit in the tx buffer arena
 typedef struct
 {
     uint8_t buffer[FLASH_BUFFER_SIZE];
@@ -45,31 +43,47 @@ parser_context_t ctx_parsed_tx;
 
 void tx_initialize()
 {
-    buffering_init(
-        ram_buffer,
-        sizeof(ram_buffer),
-        (uint8_t *)N_appdata.buffer,
-        sizeof(N_appdata.buffer));
+    tx_buffer_init((uint8_t *)N_appdata.buffer, sizeof(N_appdata.buffer));
 }
 
-void tx_reset()
+void tx_reset(uint32_t max_length)
 {
-    buffering_reset();
+    tx_buffer_reset(max_length);
+    parser_parse_init(&ctx_parsed_tx);
+}
+
+// The tokens may need the RAM of a transaction kept in the arena, it is moved to flash then
+__Z_INLINE parser_error_t tx_parse_chunk()
+{
+    parser_error_t err = parser_parse_chunk(&ctx_parsed_tx, tx_get_buffer(), tx_get_buffer_length());
+    if (err == parser_json_too_many_tokens && tx_buffer_move_to_flash())
+    {
+        err = parser_parse_chunk(&ctx_parsed_tx, tx_get_buffer(), tx_get_buffer_length());
+    }
+    return err;
 }
 
 uint32_t tx_append(unsigned char *buffer, uint32_t length)
 {
-    return buffering_append(buffer, length);
+    const uint32_t appended = tx_buffer_append(buffer, length);
+
+    // Tokenize while the rest of the tx is being received. Errors show up again in tx_parse
+    if (appended == length)
+    {
+        tx_parse_chunk();
+    }
+
+    return appended;
 }
 
 uint32_t tx_get_buffer_length()
 {
-    return buffering_get_buffer()->pos;
+    return tx_buffer_length();
 }
 
 uint8_t *tx_get_buffer()
 {
-    return buffering_get_buffer()->data;
+    return tx_buffer_data();
 }
 
 static parser_tx_t tx_obj;
@@ -78,9 +92,23 @@ const char *tx_parse()
 {
     MEMZERO(&tx_obj, sizeof(tx_obj));
 
-    uint8_t err = parser_parse(&ctx_parsed_tx,
-                               tx_get_buffer(),
-                               tx_get_buffer_length());
+    // tokens for the chunks received so far are already there (see tx_append)
+    uint8_t err = parser_parse_finish(&ctx_parsed_tx,
+                                      tx_get_buffer(),
+                                      tx_get_buffer_length());
+    if (err == parser_json_too_many_tokens && tx_buffer_move_to_flash())
+    {
+        err = parser_parse_finish(&ctx_parsed_tx,
+                                  tx_get_buffer(),
+                                  tx_get_buffer_length());
+    }
+    if (err == parser_json_too_many_tokens)
+    {
+        // only the msgs elements being shown are tokenized
+        err = parser_parse_windowed(&ctx_parsed_tx,
+                                    tx_get_buffer(),
+                                    tx_get_buffer_length());
+    }
     zemu_log_stack("parse|parsed");
 
     if (err != parser_ok)
@@ -96,6 +124,19 @@ const char *tx_parse()
         return parser_getErrorDescription(err);
     }
 
+    // Items the review can not reach would be signed without being shown
+    uint16_t numItems = 0;
+    err = parser_getNumItems(&ctx_parsed_tx, &numItems);
+    if (err == parser_ok && numItems > TX_VIEW_MAX_ITEMS)
+    {
+        err = parser_display_too_many_items;
+    }
+
+    if (err != parser_ok)
+    {
+        return parser_getErrorDescription(err);
+    }
+
     return NULL;
 }
 
@@ -104,8 +145,9 @@ void tx_parse_reset()
     MEMZERO(&tx_obj, sizeof(tx_obj));
 }
 
-zxerr_t tx_getNumItems(uint8_t *num_items)
+zxerr_t tx_getNumItems(uint16_t *num_items)
 {
+    *num_items = 0;
     parser_error_t err = parser_getNumItems(&ctx_parsed_tx, num_items);
 
     if (err != parser_ok)
@@ -116,16 +158,16 @@ zxerr_t tx_getNumItems(uint8_t *num_items)
     return zxerr_ok;
 }
 
-zxerr_t tx_getItem(int8_t displayIdx,
+zxerr_t tx_getItem(uint16_t displayIdx,
                    char *outKey, uint16_t outKeyLen,
                    char *outVal, uint16_t outValLen,
                    uint8_t pageIdx, uint8_t *pageCount)
 {
-    uint8_t numItems = 0;
+    uint16_t numItems = 0;
 
     CHECK_ZXERR(tx_getNumItems(&numItems))
 
-    if (displayIdx < 0 || displayIdx > numItems)
+    if (displayIdx >= numItems)
     {
         return zxerr_no_data;
     }
@@ -147,3 +189,30 @@ zxerr_t tx_getItem(int8_t displayIdx,
 
     return zxerr_ok;
 }
+
+zxerr_t tx_view_getNumItems(uint8_t *num_items)
+{
+    *num_items = 0;
+    uint16_t numItems = 0;
+    CHECK_ZXERR(tx_getNumItems(&numItems))
+
+    if (numItems > TX_VIEW_MAX_ITEMS)
+    {
+        return zxerr_out_of_bounds;
+    }
+
+    *num_items = (uint8_t) numItems;
+    return zxerr_ok;
+}
+
+zxerr_t tx_view_getItem(int8_t displayIdx,
+                        char *outKey, uint16_t outKeyLen,
+                        char *outVal, uint16_t outValLen,
+                        uint8_t pageIdx, uint8_t *pageCount)
+{
+    // The view keeps the item index in a uint8_t, items past 127 arrive as negative values
+    return tx_getItem((uint8_t) displayIdx,
+                      outKey, outKeyLen,
+                      outVal, outValLen,
+                      pageIdx, pageCount);
+}
@@ -22,10 +22,12 @@
 void tx_initialize();
 
 /// Clears the transaction buffer
-void tx_reset();
+/// \param max_length upper bound of the transaction size, transactions that fit are kept in RAM
+void tx_reset(uint32_t max_length);
 
 /// Appends buffer to the end of the current transaction buffer
 /// Transaction buffer will grow until it reaches the maximum allowed size
+/// The data received so far is tokenized right away
 /// \param buffer
 /// \param length
 /// \return It returns an error message if the buffer is too small.
@@ -45,10 +47,19 @@ uint8_t *tx_get_buffer();
 const char *tx_parse();
 
 /// Return the number of items in the transaction
-zxerr_t tx_getNumItems(uint8_t *num_items);
+zxerr_t tx_getNumItems(uint16_t *num_items);
 
 /// Gets an specific item from the transaction (including paging)
-zxerr_t tx_getItem(int8_t displayIdx,
+zxerr_t tx_getItem(uint16_t displayIdx,
                    char *outKey, uint16_t outKeyLen,
                    char *outValue, uint16_t outValueLen,
                    uint8_t pageIdx, uint8_t *pageCount);
+
+/// tx_getNumItems for the zxlib view, that shows at most 255 items (tx_parse rejects larger transactions)
+zxerr_t tx_view_getNumItems(uint8_t *num_items);
+
+/// tx_getItem for the zxlib view, that passes the item index as an int8_t
+zxerr_t tx_view_getItem(int8_t displayIdx,
+                        char *outKey, uint16_t outKeyLen,
+                        char *outValue, uint16_t outValueLen,
+                        uint8_t pageIdx, uint8_t *pageCount);
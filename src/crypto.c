@@ -36,14 +36,28 @@ uint32_t viewed_bip32_path[HDPATH_LEN_DEFAULT];
 uint8_t bech32_hrp_len;
 char bech32_hrp[MAX_BECH32_HRP_LEN + 1];
 
-int sign_secp256k1(const uint8_t *message,
-                   unsigned int message_length,
+// digest of the transaction being received, updated with every chunk
+static cx_sha256_t tx_hash;
+
+void crypto_txHashInit(void) {
+    cx_sha256_init(&tx_hash);
+}
+
+void crypto_txHashUpdate(const uint8_t *data, uint32_t length) {
+    CX_ASSERT(cx_hash_no_throw(&tx_hash.header, 0, data, length, NULL, 0));
+}
+
+void crypto_txHashFinal(uint8_t *message_digest) {
+    // a copy is finalized so that the digest can be requested again
+    cx_sha256_t ctx;
+    MEMCPY(&ctx, &tx_hash, sizeof(ctx));
+    CX_ASSERT(cx_hash_no_throw(&ctx.header, CX_LAST, NULL, 0, message_digest, CX_SHA256_SIZE));
+}
+
+int sign_secp256k1(const uint8_t *message_digest,
                    uint8_t *signature,
                    size_t *signature_length) {
     unsigned int info = 0;
-    uint8_t message_digest[CX_SHA256_SIZE] = {0};
-        
-    cx_hash_sha256(message, message_length, message_digest, CX_SHA256_SIZE);
 
     if(bip32_derive_ecdsa_sign_hash_256(CX_CURVE_256K1,
                                     hdPath,
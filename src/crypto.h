@@ -21,14 +21,24 @@
 #include "zxerror.h"
 
 
+/// crypto_txHashInit starts the digest of a new transaction
+void crypto_txHashInit(void);
+
+/// crypto_txHashUpdate adds a chunk of the transaction to its digest
+/// \param data
+/// \param length
+void crypto_txHashUpdate(const uint8_t *data, uint32_t length);
+
+/// crypto_txHashFinal returns the digest of the chunks received so far
+/// \param message_digest CX_SHA256_SIZE bytes
+void crypto_txHashFinal(uint8_t *message_digest);
+
 /// sign_secp256k1
-/// \param message
-/// \param message_length
+/// \param message_digest sha256 of the message (see crypto_txHashFinal)
 /// \param signature
 /// \param signature_length
 /// \return
-int sign_secp256k1(const uint8_t *message,
-                   unsigned int message_length,
+int sign_secp256k1(const uint8_t *message_digest,
                    uint8_t *signature,
                    size_t *signature_length);
 
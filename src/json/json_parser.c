@@ -21,20 +21,94 @@
 
 #define EQUALS(_P, _Q, _LEN) (MEMCMP( (const void*) PIC(_P), (const void*) PIC(_Q), (_LEN))==0)
 
-parser_error_t json_parse(parsed_json_t *parsed_json, const char *buffer, uint16_t bufferLen) {
-    jsmn_parser parser;
-    jsmn_init(&parser);
+#if !defined(JSMN_PACKED)
+// Post-parse pass that links every token to its next sibling.
+// Going backwards, the subtree of token i ends at the first following token that starts after i ends.
+// Children hops reuse the links that were already computed, so every token is visited a constant
+// number of times.
+static void json_link_siblings(parsed_json_t *json) {
+    const uint16_t numberOfTokens = (uint16_t) json->numberOfTokens;
+
+    for (int32_t i = (int32_t) numberOfTokens - 1; i >= 0; i--) {
+        uint16_t next = (uint16_t) (i + 1);
+        while (next < numberOfTokens && json->tokens[next].start < json->tokens[i].end) {
+            next = json->next_sibling[next];
+        }
+        json->next_sibling[i] = next;
+    }
+}
+#endif
+
+__Z_INLINE parser_error_t json_parse_error(int32_t num_tokens) {
+    switch (num_tokens) {
+        case JSMN_ERROR_NOMEM:
+            return parser_json_too_many_tokens;
+        case JSMN_ERROR_INVAL:
+            return parser_unexpected_characters;
+        case JSMN_ERROR_PART:
+            return parser_json_incomplete_json;
+        case 0:
+            return parser_json_zero_tokens;
+        default:
+            return parser_json_unexpected_error;
+    }
+}
+
+// Primitives are not quoted, so one that is cut at the end of the data looks complete to the tokenizer.
+// Data up to a value separator or closing bracket never ends in the middle of a primitive.
+__Z_INLINE bool is_value_end(char c) {
+    return c == ',' || c == '}' || c == ']';
+}
 
+parser_error_t json_parse(parsed_json_t *parsed_json,
+                          jsmntok_t *tokens, uint16_t max_tokens,
+                          const char *buffer, uint16_t bufferLen) {
+    json_parse_init(parsed_json, tokens, max_tokens);
+    return json_parse_finish(parsed_json, buffer, bufferLen);
+}
+
+void json_parse_init(parsed_json_t *parsed_json, jsmntok_t *tokens, uint16_t max_tokens) {
     MEMZERO(parsed_json, sizeof(parsed_json_t));
+    parsed_json->tokens = tokens;
+    parsed_json->maxTokens = max_tokens < MAX_NUMBER_OF_TOKENS ? max_tokens : MAX_NUMBER_OF_TOKENS;
+    jsmn_init(&parsed_json->parser);
+}
+
+parser_error_t json_parse_chunk(parsed_json_t *parsed_json, const char *buffer, uint16_t bufferLen) {
+    uint16_t safeLen = bufferLen;
+    while (safeLen > parsed_json->parser.pos && !is_value_end(buffer[safeLen - 1])) {
+        safeLen--;
+    }
+
+    if (safeLen <= parsed_json->parser.pos) {
+        return parser_ok;
+    }
+
+    const int32_t num_tokens = jsmn_parse(
+            &parsed_json->parser,
+            buffer,
+            safeLen,
+            parsed_json->tokens,
+            parsed_json->maxTokens);
+
+    // open strings and containers are completed by the next chunks
+    if (num_tokens < 0 && num_tokens != JSMN_ERROR_PART) {
+        return json_parse_error(num_tokens);
+    }
+
+    return parser_ok;
+}
+
+parser_error_t json_parse_finish(parsed_json_t *parsed_json, const char *buffer, uint16_t bufferLen) {
     parsed_json->buffer = buffer;
     parsed_json->bufferLen = bufferLen;
 
     int32_t num_tokens = jsmn_parse(
-            &parser,
+            &parsed_json->parser,
             parsed_json->buffer,
             parsed_json->bufferLen,
             parsed_json->tokens,
-            MAX_NUMBER_OF_TOKENS);
+            parsed_json->maxTokens);
 
 #ifdef APP_TESTING
     char tmpBuffer[100];
@@ -43,26 +117,19 @@ parser_error_t json_parse(parsed_json_t *parsed_json, const char *buffer, uint16
 #endif
 
     if (num_tokens < 0) {
-        switch (num_tokens) {
-            case JSMN_ERROR_NOMEM:
-                return parser_json_too_many_tokens;
-            case JSMN_ERROR_INVAL:
-                return parser_unexpected_characters;
-            case JSMN_ERROR_PART:
-                return parser_json_incomplete_json;
-            case 0:
-                return parser_json_zero_tokens;
-            default:
-                return parser_json_unexpected_error;
-        }
+        return json_parse_error(num_tokens);
     }
 
     // We cannot support if number of tokens exceeds the limit
-    if (num_tokens > MAX_NUMBER_OF_TOKENS) {
+    if (num_tokens > parsed_json->maxTokens) {
         return parser_json_too_many_tokens;
     }
 
     parsed_json->numberOfTokens = num_tokens;
+#if !defined(JSMN_PACKED)
+    // packed tokens are linked by the tokenizer
+    json_link_siblings(parsed_json);
+#endif
     parsed_json->isValid = true;
 
     return parser_ok;
@@ -72,26 +139,12 @@ parser_error_t array_get_element_count(const parsed_json_t *json,
                                        uint16_t array_token_index,
                                        uint16_t *number_elements) {
     *number_elements = 0;
-    if (array_token_index < 0 || array_token_index > json->numberOfTokens) {
+    if (array_token_index >= json->numberOfTokens) {
         return parser_no_data;
     }
 
-    jsmntok_t array_token = json->tokens[array_token_index];
-    uint16_t token_index = array_token_index;
-    uint16_t prev_element_end = array_token.start;
-    while (true) {
-        token_index++;
-        if (token_index >= json->numberOfTokens) {
-            break;
-        }
-        jsmntok_t current_token = json->tokens[token_index];
-        if (current_token.start > array_token.end) {
-            break;
-        }
-        if (current_token.start <= prev_element_end) {
-            continue;
-        }
-        prev_element_end = current_token.end;
+    const uint16_t end = json_next_sibling(json, array_token_index);
+    for (uint16_t i = json_first_child(json, array_token_index); i < end; i = json_next_sibling(json, i)) {
         (*number_elements)++;
     }
 
@@ -102,62 +155,37 @@ parser_error_t array_get_nth_element(const parsed_json_t *json,
                                      uint16_t array_token_index,
                                      uint16_t element_index,
                                      uint16_t *token_index) {
-    if (array_token_index < 0 || array_token_index > json->numberOfTokens) {
+    if (array_token_index >= json->numberOfTokens) {
         return parser_no_data;
     }
 
-    jsmntok_t array_token = json->tokens[array_token_index];
-    *token_index = array_token_index;
+    const uint16_t end = json_next_sibling(json, array_token_index);
+    uint16_t element_token_index = json_first_child(json, array_token_index);
+    for (uint16_t i = 0; i < element_index && element_token_index < end; i++) {
+        element_token_index = json_next_sibling(json, element_token_index);
+    }
 
-    uint16_t element_count = 0;
-    uint16_t prev_element_end = array_token.start;
-    while (true) {
-        (*token_index)++;
-        if (*token_index >= json->numberOfTokens) {
-            break;
-        }
-        jsmntok_t current_token = json->tokens[*token_index];
-        if (current_token.start > array_token.end) {
-            break;
-        }
-        if (current_token.start <= prev_element_end) {
-            continue;
-        }
-        prev_element_end = current_token.end;
-        if (element_count == element_index) {
-            return parser_ok;
-        }
-        element_count++;
+    if (element_token_index >= end) {
+        return parser_no_data;
     }
 
-    return parser_no_data;
+    *token_index = element_token_index;
+    return parser_ok;
 }
 
 parser_error_t object_get_element_count(const parsed_json_t *json,
                                         uint16_t object_token_index,
                                         uint16_t *element_count) {
     *element_count = 0;
-    if (object_token_index < 0 || object_token_index > json->numberOfTokens) {
+    if (object_token_index >= json->numberOfTokens) {
         return parser_no_data;
     }
 
-    jsmntok_t object_token = json->tokens[object_token_index];
-    uint16_t token_index = object_token_index;
-    uint16_t prev_element_end = object_token.start;
-    token_index++;
-    while (true) {
-        if (token_index >= json->numberOfTokens) {
-            break;
-        }
-        jsmntok_t key_token = json->tokens[token_index++];
-        jsmntok_t value_token = json->tokens[token_index];
-        if (key_token.start > object_token.end) {
-            break;
-        }
-        if (key_token.start <= prev_element_end) {
-            continue;
-        }
-        prev_element_end = value_token.end;
+    // children alternate key and value
+    const uint16_t end = json_next_sibling(json, object_token_index);
+    for (uint16_t key_index = json_first_child(json, object_token_index);
+         key_index + 1 < end;
+         key_index = json_next_sibling(json, key_index + 1)) {
         (*element_count)++;
     }
 
@@ -169,42 +197,30 @@ parser_error_t object_get_nth_key(const parsed_json_t *json,
                                   uint16_t object_element_index,
                                   uint16_t *token_index) {
     *token_index = object_token_index;
-    if (object_token_index < 0 || object_token_index > json->numberOfTokens) {
+    if (object_token_index >= json->numberOfTokens) {
         return parser_no_data;
     }
 
-    jsmntok_t object_token = json->tokens[object_token_index];
-    uint16_t element_count = 0;
-    uint16_t prev_element_end = object_token.start;
-    (*token_index)++;
-    while (true) {
-        if (*token_index >= json->numberOfTokens) {
-            break;
-        }
-        jsmntok_t key_token = json->tokens[(*token_index)++];
-        jsmntok_t value_token = json->tokens[*token_index];
-        if (key_token.start > object_token.end) {
-            break;
-        }
-        if (key_token.start <= prev_element_end) {
-            continue;
-        }
-        prev_element_end = value_token.end;
-        if (element_count == object_element_index) {
-            (*token_index)--;
-            return parser_ok;
-        }
-        element_count++;
+    const uint16_t end = json_next_sibling(json, object_token_index);
+    uint16_t key_index = json_first_child(json, object_token_index);
+    for (uint16_t i = 0; i < object_element_index && key_index < end; i++) {
+        // skip key and value
+        key_index = json_next_sibling(json, key_index + 1);
     }
 
-    return parser_no_data;
+    if (key_index + 1 >= end) {
+        return parser_no_data;
+    }
+
+    *token_index = key_index;
+    return parser_ok;
 }
 
 parser_error_t object_get_nth_value(const parsed_json_t *json,
                                     uint16_t object_token_index,
                                     uint16_t object_element_index,
                                     uint16_t *key_index) {
-    if (object_token_index < 0 || object_token_index > json->numberOfTokens) {
+    if (object_token_index >= json->numberOfTokens) {
         return parser_no_data;
     }
 
@@ -218,33 +234,23 @@ parser_error_t object_get_value(const parsed_json_t *json,
                                 uint16_t object_token_index,
                                 const char *key_name,
                                 uint16_t *token_index) {
-    if (object_token_index < 0 || object_token_index > json->numberOfTokens) {
+    if (object_token_index >= json->numberOfTokens) {
         return parser_no_data;
     }
 
-    const jsmntok_t object_token = json->tokens[object_token_index];
+    const uint16_t key_name_len = (uint16_t) strlen(key_name);
+    const uint16_t end = json_next_sibling(json, object_token_index);
 
-    *token_index = object_token_index;
-    int prev_element_end = object_token.start;
-    (*token_index)++;
+    for (uint16_t key_index = json_first_child(json, object_token_index);
+         key_index + 1 < end;
+         key_index = json_next_sibling(json, key_index + 1)) {
+        const jsmntok_t key_token = json_token(json, key_index);
 
-    while (*token_index < json->numberOfTokens) {
-        const jsmntok_t key_token = json->tokens[*token_index];
-        (*token_index)++;
-        const jsmntok_t value_token = json->tokens[*token_index];
-
-        if (key_token.start > object_token.end) {
-            break;
-        }
-        if (key_token.start <= prev_element_end) {
-            continue;
-        }
-        prev_element_end = value_token.end;
-
-        if (((uint16_t) strlen(key_name)) == (key_token.end - key_token.start)) {
+        if (key_name_len == (key_token.end - key_token.start)) {
             if (EQUALS(key_name,
                        json->buffer + key_token.start,
                        key_token.end - key_token.start)) {
+                *token_index = key_index + 1;
                 return parser_ok;
             }
         }
@@ -252,3 +258,295 @@ parser_error_t object_get_value(const parsed_json_t *json,
 
     return parser_no_data;
 }
+
+#if defined(JSMN_PACKED)
+__Z_INLINE bool is_json_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+__Z_INLINE uint16_t skip_json_space(const char *buffer, uint16_t len, uint16_t pos) {
+    while (pos < len && is_json_space(buffer[pos])) {
+        pos++;
+    }
+    return pos;
+}
+
+// End of the value that starts at pos (0 if it is cut). Only strings and brackets are followed,
+// the value is checked by the tokenizer.
+static uint16_t json_value_end(const char *buffer, uint16_t len, uint16_t pos) {
+    uint16_t depth = 0;
+    bool in_string = false;
+
+    if (buffer[pos] != '"' && buffer[pos] != '{' && buffer[pos] != '[') {
+        // primitive
+        while (pos < len && !is_json_space(buffer[pos]) && !is_value_end(buffer[pos]) && buffer[pos] != ':') {
+            pos++;
+        }
+        return pos;
+    }
+
+    for (; pos < len; pos++) {
+        const char c = buffer[pos];
+        if (in_string) {
+            if (c == '\\') {
+                pos++;
+            } else if (c == '"') {
+                in_string = false;
+                if (depth == 0) {
+                    return pos + 1;
+                }
+            }
+            continue;
+        }
+
+        if (c == '"') {
+            in_string = true;
+        } else if (c == '{' || c == '[') {
+            depth++;
+        } else if (c == '}' || c == ']') {
+            depth--;
+            if (depth == 0) {
+                return pos + 1;
+            }
+        }
+    }
+    return 0;
+}
+
+// Position of the '[' of the msgs array of the root object (0 if there is none)
+static uint16_t json_find_msgs(const char *buffer, uint16_t len) {
+    uint16_t pos = skip_json_space(buffer, len, 0);
+    if (pos >= len || buffer[pos] != '{') {
+        return 0;
+    }
+    pos++;
+
+    while (true) {
+        pos = skip_json_space(buffer, len, pos);
+        if (pos >= len || buffer[pos] != '"') {
+            return 0;
+        }
+        const uint16_t key_start = pos + 1;
+        const uint16_t key_end = json_value_end(buffer, len, pos);
+        if (key_end == 0) {
+            return 0;
+        }
+
+        pos = skip_json_space(buffer, len, key_end);
+        if (pos >= len || buffer[pos] != ':') {
+            return 0;
+        }
+        pos = skip_json_space(buffer, len, pos + 1);
+        if (pos >= len) {
+            return 0;
+        }
+
+        if (key_end - 1 - key_start == 4 && EQUALS("msgs", buffer + key_start, 4)) {
+            return buffer[pos] == '[' ? pos : 0;
+        }
+
+        pos = json_value_end(buffer, len, pos);
+        if (pos == 0) {
+            return 0;
+        }
+        pos = skip_json_space(buffer, len, pos);
+        if (pos >= len || buffer[pos] != ',') {
+            return 0;
+        }
+        pos++;
+    }
+}
+
+// Tokenizes the value in [start, end) into tokens, positions are kept relative to the buffer
+static int32_t json_tokenize_value(const char *buffer, uint16_t start, uint16_t end,
+                                   jsmntok_t *tokens, uint16_t max_tokens) {
+    jsmn_parser parser;
+    jsmn_init(&parser);
+    parser.pos = start;
+
+    const int32_t num_tokens = jsmn_parse(&parser, buffer, end, tokens, max_tokens);
+    if (num_tokens <= 0) {
+        return num_tokens;
+    }
+
+    // exactly one value
+    if (tokens[0].next != num_tokens) {
+        return JSMN_ERROR_INVAL;
+    }
+    return num_tokens;
+}
+
+parser_error_t json_parse_windowed(parsed_json_t *parsed_json, json_window_t *window,
+                                   jsmntok_t *tokens, uint16_t max_tokens,
+                                   const char *buffer, uint16_t bufferLen) {
+    json_parse_init(parsed_json, tokens, max_tokens);
+    parsed_json->buffer = buffer;
+    parsed_json->bufferLen = bufferLen;
+    MEMZERO(window, sizeof(json_window_t));
+
+    jsmn_parser *parser = &parsed_json->parser;
+    max_tokens = (uint16_t) parsed_json->maxTokens;
+
+    const uint16_t msgs_pos = json_find_msgs(buffer, bufferLen);
+    if (msgs_pos == 0) {
+        return parser_json_too_many_tokens;
+    }
+
+    // root items up to msgs and the msgs array
+    int32_t num_tokens = jsmn_parse(parser, buffer, msgs_pos + 1, tokens, max_tokens);
+    if (num_tokens < 0 && num_tokens != JSMN_ERROR_PART) {
+        return json_parse_error(num_tokens);
+    }
+    window->msgsToken = parser->toknext - 1;
+    if (tokens[window->msgsToken].type != JSMN_ARRAY) {
+        return parser_json_unexpected_error;
+    }
+
+    // elements, one token each. Their children are tokenized after them to check them and count them.
+    uint16_t next_full = window->msgsToken + 1;
+    uint16_t pos = skip_json_space(buffer, bufferLen, msgs_pos + 1);
+    while (pos < bufferLen && buffer[pos] != ']') {
+        const uint16_t element_end = json_value_end(buffer, bufferLen, pos);
+        if (element_end == 0) {
+            return parser_json_incomplete_json;
+        }
+
+        const uint16_t element = parser->toknext;
+        if (element >= max_tokens) {
+            return parser_json_too_many_tokens;
+        }
+        num_tokens = json_tokenize_value(buffer, pos, element_end, tokens + element, max_tokens - element);
+        if (num_tokens <= 0) {
+            return json_parse_error(num_tokens);
+        }
+        if ((uint16_t) num_tokens > window->capacity) {
+            window->capacity = (uint16_t) num_tokens;
+        }
+        if (next_full + num_tokens > JSMN_PACKED_MAX_TOKENS) {
+            return parser_json_too_many_tokens;
+        }
+
+        next_full += (uint16_t) num_tokens;
+        tokens[element].next = next_full;
+        parser->toknext++;
+        window->numElements++;
+
+        pos = skip_json_space(buffer, bufferLen, element_end);
+        if (pos < bufferLen && buffer[pos] == ',') {
+            pos = skip_json_space(buffer, bufferLen, pos + 1);
+        } else if (pos < bufferLen && buffer[pos] != ']') {
+            return parser_unexpected_characters;
+        }
+    }
+    if (pos >= bufferLen) {
+        return parser_json_incomplete_json;
+    }
+
+    // the tokenizer closes msgs and continues with the rest of the root object
+    parser->pos = pos;
+    num_tokens = jsmn_parse(parser, buffer, bufferLen, tokens, max_tokens);
+    if (num_tokens < 0) {
+        return json_parse_error(num_tokens);
+    }
+
+    const uint16_t num_skeleton = parser->toknext;
+    const uint16_t last_element = window->msgsToken + 1 + window->numElements;
+    const uint16_t hidden = next_full - last_element;
+    if (num_skeleton + hidden > JSMN_PACKED_MAX_TOKENS) {
+        return parser_json_too_many_tokens;
+    }
+    if (num_skeleton + window->capacity > max_tokens) {
+        return parser_json_too_many_tokens;
+    }
+
+    // links beyond the elements skip their children
+    for (uint16_t i = 0; i < num_skeleton; i++) {
+        const bool is_element = i > window->msgsToken && i < last_element;
+        if (!is_element && tokens[i].next >= last_element) {
+            tokens[i].next += hidden;
+        }
+    }
+
+    window->numSkeletonTokens = num_skeleton;
+    window->cursorElement = window->msgsToken + 1;
+    window->cursorStart = window->msgsToken + 1;
+    window->tokens = tokens + num_skeleton;
+    parsed_json->window = window;
+    parsed_json->numberOfTokens = num_skeleton + hidden;
+    parsed_json->isValid = true;
+
+    return parser_ok;
+}
+
+jsmntok_t json_window_token(const parsed_json_t *json, json_window_t *window, uint16_t token_index) {
+    const uint16_t first_element = window->msgsToken + 1;
+    const uint16_t last_element = first_element + window->numElements;
+    const uint16_t last_full = window->numElements > 0 ? json->tokens[last_element - 1].next : first_element;
+
+    const jsmntok_t unset = {.start = JSMN_POS_UNSET, .end = JSMN_POS_UNSET, .type = JSMN_UNDEFINED,
+                             .next = token_index + 1};
+
+    if (token_index < first_element) {
+        return json->tokens[token_index];
+    }
+    if (token_index >= last_full) {
+        const uint32_t skeleton_index = (uint32_t) token_index - last_full + last_element;
+        return skeleton_index < window->numSkeletonTokens ? json->tokens[skeleton_index] : unset;
+    }
+
+    // element that contains the token: the one found last, the one after it, or a binary search
+    // (elements end in increasing order)
+    if (token_index >= json->tokens[window->cursorElement].next &&
+        window->cursorElement + 1 < last_element &&
+        token_index < json->tokens[window->cursorElement + 1].next) {
+        window->cursorStart = json->tokens[window->cursorElement].next;
+        window->cursorElement++;
+    } else if (token_index < window->cursorStart || token_index >= json->tokens[window->cursorElement].next) {
+        uint16_t low = first_element;
+        uint16_t high = last_element - 1;
+        while (low < high) {
+            const uint16_t mid = low + (high - low) / 2;
+            if (json->tokens[mid].next <= token_index) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        window->cursorElement = low;
+        window->cursorStart = low == first_element ? first_element : json->tokens[low - 1].next;
+    }
+
+    const uint16_t element = window->cursorElement;
+    if (token_index == window->cursorStart) {
+        return json->tokens[element];
+    }
+
+    jsmntok_t *window_tokens = window->tokens;
+    if (window->element != element) {
+        window->element = 0;
+        const int32_t num_tokens = json_tokenize_value(json->buffer,
+                                                       json->tokens[element].start,
+                                                       json->tokens[element].end,
+                                                       window_tokens, window->capacity);
+        if (num_tokens <= 0) {
+            return unset;
+        }
+        for (int32_t i = 0; i < num_tokens; i++) {
+            window_tokens[i].next += window->cursorStart;
+        }
+        window->element = element;
+    }
+
+    return window_tokens[token_index - window->cursorStart];
+}
+#else
+parser_error_t json_parse_windowed(parsed_json_t *parsed_json __attribute__((unused)),
+                                   json_window_t *window __attribute__((unused)),
+                                   jsmntok_t *tokens __attribute__((unused)),
+                                   uint16_t max_tokens __attribute__((unused)),
+                                   const char *transaction __attribute__((unused)),
+                                   uint16_t transaction_length __attribute__((unused))) {
+    // without the next links in the tokens, the skeleton cannot skip the children of the elements
+    return parser_json_too_many_tokens;
+}
+#endif
@@ -31,46 +31,183 @@ extern "C" {
 #endif
 
 /// Max number of accepted tokens in the JSON input
+/// It can be overridden at build time (e.g. host builds)
+#if !defined(MAX_NUMBER_OF_TOKENS)
 #define MAX_NUMBER_OF_TOKENS   768
 
 // we must limit the number
 #if defined(TARGET_NANOS)
 #undef MAX_NUMBER_OF_TOKENS
+#if defined(JSMN_PACKED)
+#define MAX_NUMBER_OF_TOKENS    140
+#else
 #define MAX_NUMBER_OF_TOKENS    70
 #endif
+#endif
 
 #if defined(TARGET_STAX)
 #undef MAX_NUMBER_OF_TOKENS
 #define MAX_NUMBER_OF_TOKENS    600
 #endif
+#endif
+
+#if defined(JSMN_PACKED) && MAX_NUMBER_OF_TOKENS > JSMN_PACKED_MAX_TOKENS
+#error "MAX_NUMBER_OF_TOKENS does not fit in packed tokens"
+#endif
 
 #define ROOT_TOKEN_INDEX 0
 
 //---------------------------------------------
 
+// Tokens of a json with more tokens than fit in the storage (see json_parse_windowed).
+// The storage keeps a skeleton: every token but the children of the msgs elements, linked with the indices
+// of the full tokenization. The children of one element at a time are tokenized into a window after it.
+// The window is a cache updated by the readers, so it is owned by the caller and not by parsed_json_t.
+typedef struct {
+    uint16_t numSkeletonTokens;
+    // msgs array, it has the same index in the skeleton and in the full tokenization
+    uint16_t msgsToken;
+    uint16_t numElements;
+    // tokens of the largest element
+    uint16_t capacity;
+    // skeleton index of the element in the window (0 when there is none)
+    uint16_t element;
+    // element found last (skeleton index) and its full index
+    uint16_t cursorElement;
+    uint16_t cursorStart;
+    // storage of the window, after the skeleton
+    jsmntok_t *tokens;
+} json_window_t;
+
 // Context that keeps all the parsed data together. That includes:
 //  - parsed json tokens
 //  - re-created SendMsg struct with indices pointing to tokens in parsed json
 typedef struct {
     uint8_t isValid;
     uint32_t numberOfTokens;
-    jsmntok_t tokens[MAX_NUMBER_OF_TOKENS];
+    // token storage, up to maxTokens (at most MAX_NUMBER_OF_TOKENS).
+    // maxTokens may grow between chunks as long as the storage stays in place
+    jsmntok_t *tokens;
+    uint16_t maxTokens;
+#if !defined(JSMN_PACKED)
+    // index of the next token at the same level (i.e. the first token after the subtree)
+    // packed tokens carry this link themselves
+    uint16_t next_sibling[MAX_NUMBER_OF_TOKENS];
+#endif
     const char *buffer;
     uint16_t bufferLen;
+    // tokenizer state, kept between json_parse_chunk calls
+    jsmn_parser parser;
+#if defined(JSMN_PACKED)
+    // set by json_parse_windowed, NULL otherwise
+    json_window_t *window;
+#endif
 } parsed_json_t;
 
+#if defined(JSMN_PACKED)
+/// Token of a json parsed by json_parse_windowed, the window is moved to the element that contains it
+/// \param json
+/// \param window: window of json, updated
+/// \param token_index index in the full tokenization
+/// \return token
+jsmntok_t json_window_token(const parsed_json_t *json, json_window_t *window, uint16_t token_index);
+#endif
+
+/// Token token_index. Use it instead of tokens[], that only has the skeleton of a windowed json
+static inline jsmntok_t json_token(const parsed_json_t *json, uint16_t token_index) {
+#if defined(JSMN_PACKED)
+    if (json->window != NULL) {
+        return json_window_token(json, json->window, token_index);
+    }
+#endif
+    return json->tokens[token_index];
+}
+
+/// Tokens of the storage in use, the rest can be used by others
+static inline uint16_t json_tokens_in_use(const parsed_json_t *json) {
+#if defined(JSMN_PACKED)
+    if (json->window != NULL) {
+        return json->window->numSkeletonTokens + json->window->capacity;
+    }
+#endif
+    return (uint16_t) json->numberOfTokens;
+}
+
+// Tree navigation
+// Tokens are stored in document order, so the first child of a container is the token right after it.
+// Object children alternate key and value tokens. Children of a container are visited with:
+//
+//   for (uint16_t i = json_first_child(json, c); i < json_next_sibling(json, c); i = json_next_sibling(json, i))
+
+/// Index of the first child of a container token (only valid if it is below json_next_sibling)
+static inline uint16_t json_first_child(const parsed_json_t *json __attribute__((unused)), uint16_t token_index) {
+    return token_index + 1;
+}
+
+/// Index of the next token at the same level. For the last child, this points past the parent subtree.
+static inline uint16_t json_next_sibling(const parsed_json_t *json, uint16_t token_index) {
+#if defined(JSMN_PACKED)
+    return json_token(json, token_index).next;
+#else
+    return json->next_sibling[token_index];
+#endif
+}
+
 //---------------------------------------------
 // NEW JSON PARSER CODE
 
 /// Parse json to create a token representation
 /// \param parsed_json
+/// \param tokens: token storage
+/// \param max_tokens: number of tokens that fit in the storage
 /// \param transaction
 /// \param transaction_length
 /// \return Error message
 parser_error_t json_parse(parsed_json_t *parsed_json,
+                          jsmntok_t *tokens, uint16_t max_tokens,
                           const char *transaction,
                           uint16_t transaction_length);
 
+/// Start an incremental parse, for json that is received in chunks
+/// \param parsed_json
+/// \param tokens: token storage
+/// \param max_tokens: number of tokens that fit in the storage
+void json_parse_init(parsed_json_t *parsed_json, jsmntok_t *tokens, uint16_t max_tokens);
+
+/// Tokenize the data received so far. Tokens only keep offsets, so the buffer may move between calls
+/// as long as it keeps the data that was already given
+/// \param parsed_json
+/// \param transaction: all data received so far
+/// \param transaction_length
+/// \return Error message. Incomplete data is not an error
+parser_error_t json_parse_chunk(parsed_json_t *parsed_json,
+                                const char *transaction,
+                                uint16_t transaction_length);
+
+/// Tokenize the remaining data and complete the token representation
+/// \param parsed_json
+/// \param transaction: full json
+/// \param transaction_length
+/// \return Error message
+parser_error_t json_parse_finish(parsed_json_t *parsed_json,
+                                 const char *transaction,
+                                 uint16_t transaction_length);
+
+/// Parse json with more tokens than fit in the storage. Only the tokens of the root items and of the msgs
+/// elements themselves are kept, the children of every element are tokenized again when they are read
+/// (see json_token). Every element is tokenized once here to check it.
+/// \param parsed_json
+/// \param window: window state, it must outlive parsed_json
+/// \param tokens: token storage, for the skeleton and for the tokens of the largest element
+/// \param max_tokens: number of tokens that fit in the storage
+/// \param transaction
+/// \param transaction_length
+/// \return Error message
+parser_error_t json_parse_windowed(parsed_json_t *parsed_json, json_window_t *window,
+                                   jsmntok_t *tokens, uint16_t max_tokens,
+                                   const char *transaction,
+                                   uint16_t transaction_length);
+
 /// Get the number of elements in the array
 /// \param json
 /// \param array_token_index
@@ -0,0 +1,204 @@
+/*******************************************************************************
+*   (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+// Generated by scripts/gen_known_keys.py from src/known_keys.spec. Do not edit.
+
+// Minimal perfect hash over (parent id, key name) of the known keys, see scripts/gen_known_keys.py.
+// Keys are stored by id, strings are packed in a single pool.
+// Flash: 812 bytes (pool 493, keys 248, values 24, hash 47)
+#include "known_keys.h"
+#include "zxmacros.h"
+
+#define KNOWN_KEYS_FIRST_ID 2
+#define KNOWN_KEYS_COUNT 31
+#define KNOWN_KEYS_BUCKETS 16
+#define KNOWN_KEYS_SEED 0x811C9DC5u
+#define KNOWN_KEYS_FNV_PRIME 16777619u
+#define KNOWN_KEYS_GOLDEN 0x9E3779B1u
+
+typedef struct {
+    uint8_t parent;
+    uint8_t name_len;
+    // values in known_values
+    uint8_t first_value;
+    uint8_t num_values;
+    // offsets in known_keys_pool, label is 0 when there is none
+    uint16_t name;
+    uint16_t label;
+} known_key_t;
+
+typedef struct {
+    uint16_t value;
+    uint16_t label;
+} known_value_t;
+
+static const char known_keys_pool[] =
+        "\0"
+        "chain_id\0"
+        "Chain ID\0"
+        "account_number\0"
+        "Account\0"
+        "sequence\0"
+        "Sequence\0"
+        "memo\0"
+        "Memo\0"
+        "msgs\0"
+        "source\0"
+        "Source\0"
+        "data\0"
+        "Data\0"
+        "type\0"
+        "value\0"
+        "amount\0"
+        "delegator_address\0"
+        "inputs\0"
+        "coins\0"
+        "outputs\0"
+        "address\0"
+        "Send from\0"
+        "Send input coins\0"
+        "Send to\0"
+        "Send output coins\0"
+        "voting_period\0"
+        "Voting period (in ns)\0"
+        "refid\0"
+        "Cancel order ID\0"
+        "1\0"
+        "Good 'Til Expiry\0"
+        "3\0"
+        "Immediate or Cancel\0"
+        "timeinforce\0"
+        "Time in force\0"
+        "Market order\0"
+        "2\0"
+        "Limit order\0"
+        "ordertype\0"
+        "Create order type\0"
+        "id\0"
+        "Create order ID\0"
+        "Buy\0"
+        "Sell\0"
+        "side\0"
+        "Side\0"
+        "price\0"
+        "Price\0"
+        "quantity\0"
+        "Quantity\0"
+        "sender\0"
+        "Sender\0"
+        "symbol\0"
+        "Symbol";
+
+static const uint8_t known_keys_displacement[KNOWN_KEYS_BUCKETS] = {
+        1, 2, 3, 0, 0, 0, 9, 0,
+        16, 8, 0, 0, 46, 2, 15, 18,
+};
+
+static const uint8_t known_keys_slot_id[KNOWN_KEYS_COUNT] = {
+        key_msgs_value_amount, key_msgs_inputs_address, key_msgs_value_outputs_coins, key_msgs_timeinforce, key_msgs, key_source, key_msgs_type, key_msgs_outputs_address,
+        key_msgs_sender, key_account_number, key_msgs_outputs_coins, key_msgs_quantity, key_msgs_voting_period, key_msgs_outputs, key_msgs_inputs_coins, key_msgs_price,
+        key_msgs_ordertype, key_msgs_value, key_memo, key_sequence, key_msgs_inputs, key_msgs_value_delegator_address, key_data, key_msgs_value_inputs_coins,
+        key_msgs_id, key_msgs_symbol, key_chain_id, key_msgs_refid, key_msgs_value_inputs, key_msgs_side, key_msgs_value_outputs,
+};
+
+// by key id
+static const known_key_t known_keys[KNOWN_KEYS_COUNT] = {
+        {1, 8, 0, 0, 1, 10},    // chain_id
+        {1, 14, 0, 0, 19, 34},    // account_number
+        {1, 8, 0, 0, 42, 51},    // sequence
+        {1, 4, 0, 0, 60, 65},    // memo
+        {1, 4, 0, 0, 70, 0},    // msgs
+        {1, 6, 0, 0, 75, 82},    // source
+        {1, 4, 0, 0, 89, 94},    // data
+        {6, 4, 0, 0, 99, 0},    // msgs/type
+        {6, 5, 0, 0, 104, 0},    // msgs/value
+        {10, 6, 0, 0, 110, 0},    // msgs/value/amount
+        {10, 17, 0, 0, 117, 0},    // msgs/value/delegator_address
+        {10, 6, 0, 0, 135, 0},    // msgs/value/inputs
+        {13, 5, 0, 0, 142, 0},    // msgs/value/inputs/coins
+        {10, 7, 0, 0, 148, 0},    // msgs/value/outputs
+        {15, 5, 0, 0, 142, 0},    // msgs/value/outputs/coins
+        {6, 6, 0, 0, 135, 0},    // msgs/inputs
+        {17, 7, 0, 0, 156, 164},    // msgs/inputs/address
+        {17, 5, 0, 0, 142, 174},    // msgs/inputs/coins
+        {6, 7, 0, 0, 148, 0},    // msgs/outputs
+        {20, 7, 0, 0, 156, 191},    // msgs/outputs/address
+        {20, 5, 0, 0, 142, 199},    // msgs/outputs/coins
+        {6, 13, 0, 0, 217, 231},    // msgs/voting_period
+        {6, 5, 0, 0, 253, 259},    // msgs/refid
+        {6, 11, 0, 2, 316, 328},    // msgs/timeinforce
+        {6, 9, 2, 2, 369, 379},    // msgs/ordertype
+        {6, 2, 4, 0, 397, 400},    // msgs/id
+        {6, 4, 4, 2, 425, 430},    // msgs/side
+        {6, 5, 6, 0, 435, 441},    // msgs/price
+        {6, 8, 6, 0, 447, 456},    // msgs/quantity
+        {6, 6, 6, 0, 465, 472},    // msgs/sender
+        {6, 6, 6, 0, 479, 486},    // msgs/symbol
+};
+
+static const known_value_t known_values[] = {
+        {275, 277},    // msgs/timeinforce = 1
+        {294, 296},    // msgs/timeinforce = 3
+        {275, 342},    // msgs/ordertype = 1
+        {355, 357},    // msgs/ordertype = 2
+        {275, 416},    // msgs/side = 1
+        {355, 420},    // msgs/side = 2
+};
+
+__Z_INLINE uint32_t known_keys_hash(uint8_t parent, const char *name, uint16_t name_len) {
+    uint32_t h = (KNOWN_KEYS_SEED ^ parent) * KNOWN_KEYS_FNV_PRIME;
+    for (uint16_t i = 0; i < name_len; i++) {
+        h = (h ^ (uint8_t) name[i]) * KNOWN_KEYS_FNV_PRIME;
+    }
+    return h;
+}
+
+key_id_e known_key_find(key_id_e parent, const char *name, uint16_t name_len) {
+    const uint32_t h = known_keys_hash((uint8_t) parent, name, name_len);
+    const uint32_t bucket = ((h >> 16) * KNOWN_KEYS_BUCKETS) >> 16;
+    const uint32_t x = (h ^ known_keys_displacement[bucket]) * KNOWN_KEYS_GOLDEN;
+    const uint32_t slot = ((x >> 16) * KNOWN_KEYS_COUNT) >> 16;
+
+    // every name hashes to some slot, so the key there must be checked
+    const uint8_t key_id = known_keys_slot_id[slot];
+    const known_key_t *key = &known_keys[key_id - KNOWN_KEYS_FIRST_ID];
+    if (key->parent != parent || key->name_len != name_len ||
+        MEMCMP(known_keys_pool + key->name, name, name_len) != 0) {
+        return key_unknown;
+    }
+    return (key_id_e) key_id;
+}
+
+const char *known_key_label(key_id_e key_id) {
+    if (key_id < KNOWN_KEYS_FIRST_ID || key_id >= NUM_KEY_IDS) {
+        return NULL;
+    }
+    const known_key_t *key = &known_keys[key_id - KNOWN_KEYS_FIRST_ID];
+    return key->label != 0 ? known_keys_pool + key->label : NULL;
+}
+
+const char *known_key_value_label(key_id_e key_id, const char *value) {
+    if (key_id < KNOWN_KEYS_FIRST_ID || key_id >= NUM_KEY_IDS) {
+        return NULL;
+    }
+    const known_key_t *key = &known_keys[key_id - KNOWN_KEYS_FIRST_ID];
+    for (uint8_t i = 0; i < key->num_values; i++) {
+        const known_value_t *known = &known_values[key->first_value + i];
+        if (strcmp(value, known_keys_pool + known->value) == 0) {
+            return known_keys_pool + known->label;
+        }
+    }
+    return NULL;
+}
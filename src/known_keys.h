@@ -0,0 +1,86 @@
+/*******************************************************************************
+*   (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+// Generated by scripts/gen_known_keys.py from src/known_keys.spec. Do not edit.
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Known key paths (see known_keys.spec)
+typedef enum {
+    key_unknown = 0,
+    // the tx object
+    key_root = 1,
+    key_chain_id,
+    key_account_number,
+    key_sequence,
+    key_memo,
+    key_msgs,
+    key_source,
+    key_data,
+    key_msgs_type,
+    key_msgs_value,
+    key_msgs_value_amount,
+    key_msgs_value_delegator_address,
+    key_msgs_value_inputs,
+    key_msgs_value_inputs_coins,
+    key_msgs_value_outputs,
+    key_msgs_value_outputs_coins,
+    key_msgs_inputs,
+    key_msgs_inputs_address,
+    key_msgs_inputs_coins,
+    key_msgs_outputs,
+    key_msgs_outputs_address,
+    key_msgs_outputs_coins,
+    key_msgs_voting_period,
+    key_msgs_refid,
+    key_msgs_timeinforce,
+    key_msgs_ordertype,
+    key_msgs_id,
+    key_msgs_side,
+    key_msgs_price,
+    key_msgs_quantity,
+    key_msgs_sender,
+    key_msgs_symbol,
+
+    NUM_KEY_IDS
+} key_id_e;
+
+/// Known path of the key name below the known path parent
+/// \param parent
+/// \param name key name (it does not need to be terminated)
+/// \param name_len
+/// \return key id, key_unknown if there is no such path
+key_id_e known_key_find(key_id_e parent, const char *name, uint16_t name_len);
+
+/// Label of a known path
+/// \param key_id
+/// \return label, or NULL if the path is shown as it is
+const char *known_key_label(key_id_e key_id);
+
+/// Label of a value of a known path
+/// \param key_id
+/// \param value terminated value
+/// \return label, or NULL if the value is shown as it is
+const char *known_key_value_label(key_id_e key_id, const char *value);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,51 @@
+# Known key paths of a transaction and the labels they are shown with.
+# known_keys.h/.c are generated from this file, run after editing it:
+#
+#   python3 scripts/gen_known_keys.py
+#
+#   key <path> ["label"]            known path, shown with its label (keys without label are shown as the path)
+#   value <path> <value> "label"    value of a known path, shown with its label
+#
+# Parents must be listed before their children. Root keys are below the tx object (key_root).
+
+key chain_id "Chain ID"
+key account_number "Account"
+key sequence "Sequence"
+key memo "Memo"
+key msgs
+key source "Source"
+key data "Data"
+
+key msgs/type
+key msgs/value
+key msgs/value/amount
+key msgs/value/delegator_address
+key msgs/value/inputs
+key msgs/value/inputs/coins
+key msgs/value/outputs
+key msgs/value/outputs/coins
+
+key msgs/inputs
+key msgs/inputs/address "Send from"
+key msgs/inputs/coins "Send input coins"
+key msgs/outputs
+key msgs/outputs/address "Send to"
+key msgs/outputs/coins "Send output coins"
+
+key msgs/voting_period "Voting period (in ns)"
+key msgs/refid "Cancel order ID"
+key msgs/timeinforce "Time in force"
+key msgs/ordertype "Create order type"
+key msgs/id "Create order ID"
+key msgs/side "Side"
+key msgs/price "Price"
+key msgs/quantity "Quantity"
+key msgs/sender "Sender"
+key msgs/symbol "Symbol"
+
+value msgs/ordertype 1 "Market order"
+value msgs/ordertype 2 "Limit order"
+value msgs/side 1 "Buy"
+value msgs/side 2 "Sell"
+value msgs/timeinforce 1 "Good 'Til Expiry"
+value msgs/timeinforce 3 "Immediate or Cancel"
@@ -25,42 +25,76 @@
 #include "common/parser.h"
 #include "coin.h"
 
+// Amount lists with more coins are paged by formatting every coin
+#if !defined(AMOUNT_PAGES_MAX_COINS)
+#if defined(TARGET_NANOS)
+#define AMOUNT_PAGES_MAX_COINS 8
+#else
+#define AMOUNT_PAGES_MAX_COINS 32
+#endif
+#endif
+
+// Pages of each coin of the last amount list shown, so that a page is found formatting only its coin.
+// Page counts depend on the value size and on expert mode (amounts are not formatted in expert mode)
+typedef struct {
+    bool valid;
+    bool expert_mode;
+    uint16_t amount_token;
+    uint16_t out_val_len;
+    uint8_t num_coins;
+    uint16_t coin_token[AMOUNT_PAGES_MAX_COINS];
+    // first page of each coin, page_offset[num_coins] is the total
+    uint16_t page_offset[AMOUNT_PAGES_MAX_COINS + 1];
+} amount_pages_t;
+
+static amount_pages_t amount_pages;
+
 parser_error_t parser_parse(parser_context_t *ctx,
                             const uint8_t *data,
                             size_t dataLen) {
-    CHECK_PARSER_ERR(tx_display_readTx(ctx, data, dataLen))
-    return parser_ok;
+    parser_parse_init(ctx);
+    return parser_parse_finish(ctx, data, dataLen);
 }
 
-parser_error_t parser_validate(const parser_context_t *ctx) {
-    CHECK_PARSER_ERR(tx_validate(&parser_tx_obj.json))
-
-    // Iterate through all items to check that all can be shown and are valid
-    uint8_t numItems = 0;
-    CHECK_PARSER_ERR(parser_getNumItems(ctx, &numItems))
-
-    char tmpKey[40];
-    char tmpVal[40];
+void parser_parse_init(parser_context_t *ctx __attribute__((unused))) {
+    MEMZERO(&amount_pages, sizeof(amount_pages));
+    _readTxInit(&parser_tx_obj);
+}
 
-    for (uint8_t idx = 0; idx < numItems; idx++) {
-        uint8_t pageCount = 0;
-        CHECK_PARSER_ERR(parser_getItem(ctx, idx, tmpKey, sizeof(tmpKey), tmpVal, sizeof(tmpVal), 0, &pageCount))
-    }
+parser_error_t parser_parse_chunk(parser_context_t *ctx,
+                                  const uint8_t *data,
+                                  size_t dataLen) {
+    CHECK_PARSER_ERR(parser_init(ctx, data, dataLen))
+    return _readTxChunk(ctx, &parser_tx_obj);
+}
 
+parser_error_t parser_parse_finish(parser_context_t *ctx,
+                                   const uint8_t *data,
+                                   size_t dataLen) {
+    CHECK_PARSER_ERR(tx_display_readTx(ctx, data, dataLen))
     return parser_ok;
 }
 
-parser_error_t parser_getNumItems(const parser_context_t *ctx __attribute__((unused)), uint8_t *num_items) {
+parser_error_t parser_parse_windowed(parser_context_t *ctx,
+                                     const uint8_t *data,
+                                     size_t dataLen) {
+    MEMZERO(&amount_pages, sizeof(amount_pages));
+    CHECK_PARSER_ERR(parser_init(ctx, data, dataLen))
+    return _readTxWindowed(ctx, &parser_tx_obj);
+}
+
+parser_error_t parser_getNumItems(const parser_context_t *ctx __attribute__((unused)), uint16_t *num_items) {
     *num_items = 0;
     return tx_display_numItems(num_items);
 }
 
 __Z_INLINE bool_t parser_areEqual(uint16_t tokenIdx, const char *expected) {
-    if (parser_tx_obj.json.tokens[tokenIdx].type != JSMN_STRING) {
+    const jsmntok_t token = json_token(&parser_tx_obj.json, tokenIdx);
+    if (token.type != JSMN_STRING) {
         return bool_false;
     }
 
-    int32_t len = parser_tx_obj.json.tokens[tokenIdx].end - parser_tx_obj.json.tokens[tokenIdx].start;
+    int32_t len = token.end - token.start;
     if (len < 0) {
         return bool_false;
     }
@@ -69,7 +103,7 @@ __Z_INLINE bool_t parser_areEqual(uint16_t tokenIdx, const char *expected) {
         return bool_false;
     }
 
-    const char *p = parser_tx_obj.tx + parser_tx_obj.json.tokens[tokenIdx].start;
+    const char *p = parser_tx_obj.tx + token.start;
     for (int32_t i = 0; i < len; i++) {
         if (expected[i] != *(p + i)) {
             return bool_false;
@@ -79,28 +113,73 @@ __Z_INLINE bool_t parser_areEqual(uint16_t tokenIdx, const char *expected) {
     return bool_true;
 }
 
-__Z_INLINE bool_t parser_isAmount(char *key) {
-    if (strcmp(key, "msgs/inputs/coins") == 0) {
-        return bool_true;
+__Z_INLINE bool_t parser_isAmount(key_id_e key_id) {
+    switch (key_id) {
+        case key_msgs_inputs_coins:
+        case key_msgs_outputs_coins:
+        case key_msgs_value_inputs_coins:
+        case key_msgs_value_outputs_coins:
+        case key_msgs_value_amount:
+            return bool_true;
+        default:
+            return bool_false;
     }
+}
 
-    if (strcmp(key, "msgs/outputs/coins") == 0) {
-        return bool_true;
-    }
+// Reads a decimal amount, only digits are accepted
+__Z_INLINE parser_error_t parser_readAmount(const char *amountPtr, uint16_t amountLen, uint64_t *amount) {
+    *amount = 0;
+    for (uint16_t i = 0; i < amountLen; i++) {
+        const char c = amountPtr[i];
+        if (c < '0' || c > '9') {
+            return parser_unexpected_characters;
+        }
 
-    if (strcmp(key, "msgs/value/inputs/coins") == 0) {
-        return bool_true;
+        const uint8_t digit = (uint8_t) (c - '0');
+        if (*amount > (UINT64_MAX - digit) / 10) {
+            return parser_value_out_of_range;
+        }
+        *amount = *amount * 10 + digit;
     }
+    return parser_ok;
+}
 
-    if (strcmp(key, "msgs/value/outputs/coins") == 0) {
-        return bool_true;
-    }
+// uint64 digits, a leading zero, the decimal point and the decimals
+#define AMOUNT_MAX_CHARS (20 + 2 + COIN_DEFAULT_DENOM_FACTOR)
+
+// Writes amount / 10^COIN_DEFAULT_DENOM_FACTOR (not terminated) and returns its length, out needs AMOUNT_MAX_CHARS bytes.
+// Digits are produced from the last decimal, trailing zeros after COIN_DEFAULT_DENOM_TRIMMING decimals are dropped.
 
-    if (strcmp(key, "msgs/value/amount") == 0) {
-        return bool_true;
+__Z_INLINE uint16_t parser_printAmount(char *out, uint64_t amount) {
+    char digits[AMOUNT_MAX_CHARS];
+    uint8_t pos = sizeof(digits);
+
+    // the fraction fits in 32 bits, so its digits do not need 64 bit divisions
+    uint32_t fraction = (uint32_t) (amount % COIN_DEFAULT_DENOM_UNIT);
+    uint64_t integer = amount / COIN_DEFAULT_DENOM_UNIT;
+
+    bool trimming = true;
+    for (uint8_t decimals = COIN_DEFAULT_DENOM_FACTOR; decimals > 0; decimals--) {
+        const char digit = (char) ('0' + fraction % 10);
+        fraction /= 10;
+        if (trimming && digit == '0' && decimals > COIN_DEFAULT_DENOM_TRIMMING) {
+            continue;
+        }
+        trimming = false;
+        digits[--pos] = digit;
     }
+    if (pos < sizeof(digits)) {
+        digits[--pos] = '.';
+    }
+
+    do {
+        digits[--pos] = (char) ('0' + integer % 10);
+        integer /= 10;
+    } while (integer > 0);
 
-    return bool_false;
+    const uint16_t len = sizeof(digits) - pos;
+    MEMCPY(out, digits + pos, len);
+    return len;
 }
 
 __Z_INLINE parser_error_t parser_formatAmountItem(uint16_t amountToken,
@@ -121,7 +200,7 @@ __Z_INLINE parser_error_t parser_formatAmountItem(uint16_t amountToken,
         return parser_unexpected_field;
     }
 
-    if (parser_tx_obj.json.tokens[amountToken].type != JSMN_OBJECT) {
+    if (json_token(&parser_tx_obj.json, amountToken).type != JSMN_OBJECT) {
         return parser_unexpected_field;
     }
 
@@ -133,24 +212,14 @@ __Z_INLINE parser_error_t parser_formatAmountItem(uint16_t amountToken,
         return parser_unexpected_field;
     }
 
-    char bufferUI[160];
-    char tmpDenom[COIN_DENOM_MAXSIZE];
-    char tmpAmount[COIN_AMOUNT_MAXSIZE];
-    MEMZERO(tmpDenom, sizeof tmpDenom);
-    MEMZERO(tmpAmount, sizeof(tmpAmount));
-    MEMZERO(outVal, outValLen);
-    MEMZERO(bufferUI, sizeof(bufferUI));
-
-    const char *amountPtr = parser_tx_obj.tx + parser_tx_obj.json.tokens[amountToken + 2].start;
-    if (parser_tx_obj.json.tokens[amountToken + 2].start < 0) {
+    const jsmntok_t amountTok = json_token(&parser_tx_obj.json, amountToken + 2);
+    const jsmntok_t denomTok = json_token(&parser_tx_obj.json, amountToken + 4);
+    if (amountTok.start == JSMN_POS_UNSET) {
         return parser_unexpected_buffer_end;
     }
 
-    const int32_t amountLen = parser_tx_obj.json.tokens[amountToken + 2].end -
-                              parser_tx_obj.json.tokens[amountToken + 2].start;
-    const char *denomPtr = parser_tx_obj.tx + parser_tx_obj.json.tokens[amountToken + 4].start;
-    const int32_t denomLen = parser_tx_obj.json.tokens[amountToken + 4].end -
-                             parser_tx_obj.json.tokens[amountToken + 4].start;
+    const int32_t amountLen = amountTok.end - amountTok.start;
+    const int32_t denomLen = denomTok.end - denomTok.start;
 
     if (denomLen <= 0 || denomLen >= COIN_DENOM_MAXSIZE) {
         return parser_unexpected_error;
@@ -159,55 +228,125 @@ __Z_INLINE parser_error_t parser_formatAmountItem(uint16_t amountToken,
         return parser_unexpected_error;
     }
 
-    const size_t totalLen = amountLen + denomLen + 2;
-    if (sizeof(bufferUI) < totalLen) {
-        return parser_unexpected_buffer_end;
-    }
-
-    // Extract amount and denomination
-    MEMCPY(tmpDenom, denomPtr, denomLen);
-    MEMCPY(tmpAmount, amountPtr, amountLen);
+    char bufferUI[COIN_AMOUNT_MAXSIZE + 1 + COIN_DENOM_MAXSIZE];
+    uint16_t bufferLen = 0;
 
-    snprintf(bufferUI, sizeof(bufferUI), "%s ", tmpAmount);
     // If not expert mode, format amount (BEP2 tokens all have the same format)
     if (!tx_is_expert_mode()) {
-        if (fpstr_to_str(bufferUI, sizeof(bufferUI), tmpAmount, COIN_DEFAULT_DENOM_FACTOR) != 0) {
-            return parser_unexpected_error;
-        }
-        number_inplace_trimming(bufferUI, COIN_DEFAULT_DENOM_TRIMMING);
-        z_str3join(bufferUI, sizeof(bufferUI), "", " ");
+        uint64_t amount;
+        CHECK_PARSER_ERR(parser_readAmount(parser_tx_obj.tx + amountTok.start, (uint16_t) amountLen, &amount))
+        bufferLen = parser_printAmount(bufferUI, amount);
+    } else {
+        MEMCPY(bufferUI, parser_tx_obj.tx + amountTok.start, amountLen);
+        bufferLen = (uint16_t) amountLen;
     }
 
-    z_str3join(bufferUI, sizeof(bufferUI), "", tmpDenom);
-    pageString(outVal, outValLen, bufferUI, pageIdx, pageCount);
+    bufferUI[bufferLen++] = ' ';
+    MEMCPY(bufferUI + bufferLen, parser_tx_obj.tx + denomTok.start, denomLen);
+    bufferLen += (uint16_t) denomLen;
+
+    pageStringExt(outVal, outValLen, bufferUI, bufferLen, pageIdx, pageCount);
 
     return parser_ok;
 }
 
+__Z_INLINE parser_error_t parser_indexAmountPages(uint16_t amountToken,
+                                                  char *outVal, uint16_t outValLen) {
+    amount_pages.valid = false;
+    amount_pages.num_coins = 0;
+    amount_pages.page_offset[0] = 0;
+
+    const uint16_t endTokenIdx = json_next_sibling(&parser_tx_obj.json, amountToken);
+
+    for (uint16_t itemTokenIdx = json_first_child(&parser_tx_obj.json, amountToken);
+         itemTokenIdx < endTokenIdx;
+         itemTokenIdx = json_next_sibling(&parser_tx_obj.json, itemTokenIdx)) {
+        const uint8_t i = amount_pages.num_coins;
+        if (i >= AMOUNT_PAGES_MAX_COINS) {
+            return parser_ok;
+        }
+
+        uint8_t subpagesCount;
+        CHECK_PARSER_ERR(parser_formatAmountItem(itemTokenIdx, outVal, outValLen, 0, &subpagesCount))
+
+        amount_pages.coin_token[i] = itemTokenIdx;
+        amount_pages.page_offset[i + 1] = amount_pages.page_offset[i] + subpagesCount;
+        amount_pages.num_coins++;
+    }
+
+    amount_pages.amount_token = amountToken;
+    amount_pages.out_val_len = outValLen;
+    amount_pages.expert_mode = tx_is_expert_mode();
+    amount_pages.valid = true;
+    return parser_ok;
+}
+
+__Z_INLINE parser_error_t parser_formatAmountPage(char *outVal, uint16_t outValLen,
+                                                  uint8_t pageIdx, uint8_t *pageCount) {
+    const uint16_t totalPages = amount_pages.page_offset[amount_pages.num_coins];
+    if (totalPages > UINT8_MAX) {
+        return parser_display_too_many_pages;
+    }
+    *pageCount = (uint8_t) totalPages;
+
+    if (totalPages == 0) {
+        *pageCount = 1;
+        snprintf(outVal, outValLen, "Empty");
+        return parser_ok;
+    }
+
+    if (pageIdx >= totalPages) {
+        return parser_display_page_out_of_range;
+    }
+
+    // last coin that starts at or before pageIdx (coins without pages are skipped)
+    uint8_t coin = 0;
+    while (coin + 1 < amount_pages.num_coins && amount_pages.page_offset[coin + 1] <= pageIdx) {
+        coin++;
+    }
+
+    uint8_t dummy;
+    return parser_formatAmountItem(amount_pages.coin_token[coin], outVal, outValLen,
+                                   (uint8_t) (pageIdx - amount_pages.page_offset[coin]), &dummy);
+}
+
 __Z_INLINE parser_error_t parser_formatAmount(uint16_t amountToken,
                                               char *outVal, uint16_t outValLen,
                                               uint8_t pageIdx, uint8_t *pageCount) {
     ZEMU_LOGF(200, "[formatAmount] ------- pageidx %d", pageIdx)
 
     *pageCount = 0;
-    if (parser_tx_obj.json.tokens[amountToken].type != JSMN_ARRAY) {
+    if (json_token(&parser_tx_obj.json, amountToken).type != JSMN_ARRAY) {
         return parser_formatAmountItem(amountToken, outVal, outValLen, pageIdx, pageCount);
     }
 
-    uint8_t totalPages = 0;
+    if (!amount_pages.valid ||
+        amount_pages.amount_token != amountToken ||
+        amount_pages.out_val_len != outValLen ||
+        amount_pages.expert_mode != tx_is_expert_mode()) {
+        CHECK_PARSER_ERR(parser_indexAmountPages(amountToken, outVal, outValLen))
+    }
+
+    if (amount_pages.valid) {
+        return parser_formatAmountPage(outVal, outValLen, pageIdx, pageCount);
+    }
+
+    // Too many coins to keep their pages, count them again
+
+    uint16_t totalPages = 0;
     bool_t showItemSet = false;
-    uint8_t showPageIdx = pageIdx;
+    uint16_t showPageIdx = pageIdx;
     uint16_t showItemTokenIdx = 0;
 
-    uint16_t numberAmounts;
-    CHECK_PARSER_ERR(array_get_element_count(&parser_tx_obj.json, amountToken, &numberAmounts))
+    const uint16_t endTokenIdx = json_next_sibling(&parser_tx_obj.json, amountToken);
 
     // Count total subpagesCount and calculate correct page and TokenIdx
-    for (uint16_t i = 0; i < numberAmounts; i++) {
-        uint16_t itemTokenIdx;
+    uint16_t i = 0;
+    for (uint16_t itemTokenIdx = json_first_child(&parser_tx_obj.json, amountToken);
+         itemTokenIdx < endTokenIdx;
+         itemTokenIdx = json_next_sibling(&parser_tx_obj.json, itemTokenIdx), i++) {
         uint8_t subpagesCount;
 
-        CHECK_PARSER_ERR(array_get_nth_element(&parser_tx_obj.json, amountToken, i, &itemTokenIdx));
         CHECK_PARSER_ERR(parser_formatAmountItem(itemTokenIdx, outVal, outValLen, 0, &subpagesCount));
         totalPages += subpagesCount;
 
@@ -225,10 +364,10 @@ __Z_INLINE parser_error_t parser_formatAmount(uint16_t amountToken,
             }
         }
     }
-    *pageCount = totalPages;
-    if (pageIdx > totalPages) {
-        return parser_unexpected_value;
+    if (totalPages > UINT8_MAX) {
+        return parser_display_too_many_pages;
     }
+    *pageCount = (uint8_t) totalPages;
 
     if (totalPages == 0) {
         *pageCount = 1;
@@ -236,12 +375,38 @@ __Z_INLINE parser_error_t parser_formatAmount(uint16_t amountToken,
         return parser_ok;
     }
 
+    if (pageIdx >= totalPages) {
+        return parser_display_page_out_of_range;
+    }
+
     uint8_t dummy;
-    return parser_formatAmountItem(showItemTokenIdx, outVal, outValLen, showPageIdx, &dummy);
+    return parser_formatAmountItem(showItemTokenIdx, outVal, outValLen, (uint8_t) showPageIdx, &dummy);
+}
+
+// Value of the item (paged), and friendly key and value. key can be NULL when only the value is needed
+__Z_INLINE parser_error_t parser_renderItem(uint16_t valueToken, key_id_e keyId,
+                                            char *key, uint16_t keyLen,
+                                            char *outVal, uint16_t outValLen,
+                                            uint8_t pageIdx, uint8_t *pageCount) {
+    if (parser_isAmount(keyId)) {
+        CHECK_PARSER_ERR(parser_formatAmount(valueToken,
+                                             outVal, outValLen,
+                                             pageIdx, pageCount))
+    } else {
+        CHECK_PARSER_ERR(tx_getToken(valueToken,
+                                     outVal, outValLen,
+                                     pageIdx, pageCount))
+    }
+    CHECK_APP_CANARY()
+
+    CHECK_PARSER_ERR(tx_display_make_friendly(keyId, key, keyLen, outVal, outValLen))
+    CHECK_APP_CANARY()
+
+    return parser_ok;
 }
 
 parser_error_t parser_getItem(const parser_context_t *ctx,
-                              uint8_t displayIdx,
+                              uint16_t displayIdx,
                               char *outKey, uint16_t outKeyLen,
                               char *outVal, uint16_t outValLen,
                               uint8_t pageIdx, uint8_t *pageCount) {
@@ -252,7 +417,7 @@ parser_error_t parser_getItem(const parser_context_t *ctx,
     MEMZERO(outKey, outKeyLen);
     MEMZERO(outVal, outValLen);
 
-    uint8_t numItems;
+    uint16_t numItems;
     CHECK_PARSER_ERR(parser_getNumItems(ctx, &numItems))
     CHECK_APP_CANARY()
 
@@ -260,31 +425,42 @@ parser_error_t parser_getItem(const parser_context_t *ctx,
         return parser_unexpected_number_items;
     }
 
-    if (displayIdx < 0 || displayIdx >= numItems) {
+    if (displayIdx >= numItems) {
         return parser_display_idx_out_of_range;
     }
 
     uint16_t ret_value_token_index = 0;
-    CHECK_PARSER_ERR(tx_display_query(displayIdx, tmpKey, sizeof(tmpKey), &ret_value_token_index))
+    key_id_e keyId = key_unknown;
+    CHECK_PARSER_ERR(tx_display_query(displayIdx, tmpKey, sizeof(tmpKey), &ret_value_token_index, &keyId))
     CHECK_APP_CANARY()
     snprintf(outKey, outKeyLen, "%s", tmpKey);
 
-    if (parser_isAmount(tmpKey)) {
-        CHECK_PARSER_ERR(parser_formatAmount(ret_value_token_index,
-                                             outVal, outValLen,
-                                             pageIdx, pageCount))
-    } else {
-        CHECK_PARSER_ERR(tx_getToken(ret_value_token_index,
-                                     outVal, outValLen,
-                                     pageIdx, pageCount))
-    }
-    CHECK_APP_CANARY()
-
-    CHECK_PARSER_ERR(tx_display_make_friendly(tmpKey,sizeof(tmpKey),outVal,outValLen))
-    CHECK_APP_CANARY()
+    CHECK_PARSER_ERR(parser_renderItem(ret_value_token_index, keyId, tmpKey, sizeof(tmpKey),
+                                       outVal, outValLen, pageIdx, pageCount))
 
     snprintf(outKey, outKeyLen, "%s", tmpKey);
     CHECK_APP_CANARY()
 
     return parser_ok;
 }
+
+parser_error_t parser_validate(const parser_context_t *ctx __attribute__((unused))) {
+    CHECK_PARSER_ERR(tx_validate(&parser_tx_obj.json, &parser_tx_obj.root_slots))
+
+    // Check that the first page of every item can be shown, visiting each item once and in order.
+    // Keys are not needed for that, so they are not written
+    uint16_t numItems = 0;
+    CHECK_PARSER_ERR(tx_display_walk_start(&numItems))
+
+    char tmpVal[40];
+
+    for (uint16_t idx = 0; idx < numItems; idx++) {
+        uint16_t valueToken = 0;
+        key_id_e keyId = key_unknown;
+        uint8_t pageCount = 0;
+        CHECK_PARSER_ERR(tx_display_walk_next(&valueToken, &keyId))
+        CHECK_PARSER_ERR(parser_renderItem(valueToken, keyId, NULL, 0, tmpVal, sizeof(tmpVal), 0, &pageCount))
+    }
+
+    return parser_ok;
+}
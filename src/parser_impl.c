@@ -15,6 +15,7 @@
 ********************************************************************************/
 
 #include "parser_impl.h"
+#include "tx_buffer.h"
 
 parser_tx_t parser_tx_obj;
 
@@ -71,6 +72,10 @@ const char *parser_getErrorDescription(parser_error_t err) {
             return "display index out of range";
         case parser_display_page_out_of_range:
             return "display page out of range";
+        case parser_display_too_many_items:
+            return "Too many items to display";
+        case parser_display_too_many_pages:
+            return "Too many pages to display";
 //////
         case parser_json_zero_tokens:
             return "JSON. Zero tokens";
@@ -104,18 +109,59 @@ const char *parser_getErrorDescription(parser_error_t err) {
     }
 }
 
-parser_error_t _readTx(parser_context_t *c, parser_tx_t *v __attribute((unused))) {
-    parser_error_t err = json_parse(&parser_tx_obj.json,
-                                    (const char *) c->buffer,
-                                    c->bufferLen);
-    if (err != parser_ok) {
-        return err;
-    }
+void _readTxInit(parser_tx_t *v __attribute((unused))) {
+    uint16_t maxTokens;
+    jsmntok_t *tokens = tx_buffer_tokens(&maxTokens);
+    json_parse_init(&parser_tx_obj.json, tokens, maxTokens);
+}
+
+// Tokens get more room when the tx buffer moves the transaction to flash
+__Z_INLINE void _readTxTokens() {
+    tx_buffer_tokens(&parser_tx_obj.json.maxTokens);
+}
+
+parser_error_t _readTxChunk(parser_context_t *c, parser_tx_t *v __attribute((unused))) {
+    _readTxTokens();
+    return json_parse_chunk(&parser_tx_obj.json,
+                            (const char *) c->buffer,
+                            c->bufferLen);
+}
 
+__Z_INLINE void _readTxDone(parser_context_t *c) {
     parser_tx_obj.tx = (const char *) c->buffer;
     parser_tx_obj.flags.cache_valid = 0;
+    parser_tx_obj.root_slots.valid = false;
     parser_tx_obj.filter_msg_type_count = 0;
     parser_tx_obj.filter_msg_from_count = 0;
+}
+
+parser_error_t _readTx(parser_context_t *c, parser_tx_t *v __attribute((unused))) {
+    _readTxTokens();
+    parser_error_t err = json_parse_finish(&parser_tx_obj.json,
+                                           (const char *) c->buffer,
+                                           c->bufferLen);
+    if (err != parser_ok) {
+        return err;
+    }
+
+    _readTxDone(c);
+    return parser_ok;
+}
+
+// Window of parser_tx_obj.json when the transaction is parsed with _readTxWindowed
+static json_window_t tx_window;
+
+parser_error_t _readTxWindowed(parser_context_t *c, parser_tx_t *v __attribute((unused))) {
+    uint16_t maxTokens;
+    jsmntok_t *tokens = tx_buffer_tokens(&maxTokens);
+    parser_error_t err = json_parse_windowed(&parser_tx_obj.json, &tx_window,
+                                             tokens, maxTokens,
+                                             (const char *) c->buffer,
+                                             c->bufferLen);
+    if (err != parser_ok) {
+        return err;
+    }
 
+    _readTxDone(c);
     return parser_ok;
 }
@@ -25,19 +25,24 @@
 extern "C" {
 #endif
 
-typedef struct {
-    char str1[50];
-    char str2[50];
-} key_subst_t;
-
 extern parser_tx_t parser_tx_obj;
 
 parser_error_t parser_init(parser_context_t *ctx,
                            const uint8_t *buffer,
                            size_t bufferSize);
 
+/// Starts tokenizing a tx that is received in chunks
+void _readTxInit(parser_tx_t *v);
+
+/// Tokenizes the tx data received so far
+parser_error_t _readTxChunk(parser_context_t *c, parser_tx_t *v);
+
+/// Completes tokenization of the full tx (started by _readTxInit)
 parser_error_t _readTx(parser_context_t *c, parser_tx_t *v);
 
+/// Tokenizes the full tx keeping only the skeleton of the msgs elements (see json_parse_windowed)
+parser_error_t _readTxWindowed(parser_context_t *c, parser_tx_t *v);
+
 #ifdef __cplusplus
 }
 #endif
@@ -21,6 +21,7 @@ extern "C" {
 
 #include <stdint.h>
 #include <stddef.h>
+#include <stdbool.h>
 
 #include <json/json_parser.h>
 
@@ -35,17 +36,30 @@ typedef struct {
     uint8_t max_depth;
 
     // Index of the item to retrieve
-    int16_t item_index;
+    uint16_t item_index;
     // Chunk of the item to retrieve (assuming partitioning based on out_val_len chunks)
     int16_t page_index;
 
     // These fields (out_*) are where query results are placed
     char *out_key;
     uint16_t out_key_len;
+    // known path of the key (key_id_e)
+    uint8_t out_key_id;
     char *out_val;
     int16_t out_val_len;
 } tx_query_t;
 
+// chain_id, account_number, sequence, msgs, memo, source and data (root_item_e)
+#define NUM_REQUIRED_ROOT_PAGES 7
+
+// Root fields of the transaction, found by tx_validate while it checks the root keys
+typedef struct {
+    bool valid;
+    // value token of every root field, by root_item_e (0 if the field is missing)
+    uint16_t value_token[NUM_REQUIRED_ROOT_PAGES];
+    // chain_id is exactly COIN_DEFAULT_CHAINID
+    bool is_default_chain;
+} tx_root_slots_t;
 
 
 typedef struct {
@@ -55,6 +69,9 @@ typedef struct {
     // parsed data (tokens, etc.)
     parsed_json_t json;
 
+    // root fields, found while validating
+    tx_root_slots_t root_slots;
+
     // internal flags
     struct {
         bool cache_valid:1;
@@ -64,11 +81,11 @@ typedef struct {
     } flags;
 
     // indicates that N identical msg_type fields have been detected
-    uint8_t filter_msg_type_count;
+    uint16_t filter_msg_type_count;
     int32_t filter_msg_type_valid_idx;
 
     // indicates that N identical msg_from fields have been detected
-    uint8_t filter_msg_from_count;
+    uint16_t filter_msg_from_count;
     int32_t filter_msg_from_valid_idx;
     const char *own_addr;
 
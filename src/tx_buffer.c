@@ -0,0 +1,146 @@
+/*******************************************************************************
+*   (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include "tx_buffer.h"
+#include "zxmacros.h"
+
+typedef struct {
+    uint8_t *flash;
+    uint32_t flash_size;
+    // bytes at the end of the arena kept for the transaction (0 when it is in flash)
+    uint32_t ram_size;
+    uint32_t length;
+    bool in_flash;
+} tx_buffer_t;
+
+static uint8_t arena[TX_BUFFER_ARENA_SIZE] __attribute__((aligned(4)));
+static tx_buffer_t buffer;
+// peak arena usage since the last tx_buffer_watermark_reset
+static size_t watermark;
+
+__Z_INLINE uint8_t *tx_buffer_ram(void) {
+    return arena + sizeof(arena) - buffer.ram_size;
+}
+
+// Display table offset, after the first num_tokens tokens
+__Z_INLINE size_t tx_buffer_table_offset(uint16_t num_tokens) {
+    const size_t align = __alignof__(display_item_t);
+    return (num_tokens * sizeof(jsmntok_t) + align - 1) / align * align;
+}
+
+void tx_buffer_init(uint8_t *flash, uint32_t flash_size) {
+    buffer.flash = flash;
+    buffer.flash_size = flash_size;
+    tx_buffer_reset(0);
+}
+
+void tx_buffer_reset(uint32_t max_length) {
+    // Tokens the transaction may need. With MAX_NUMBER_OF_TOKENS, the transaction still gets at least
+    // TX_BUFFER_RAM_SIZE and the display table; beyond its RAM it is moved to flash at once.
+    size_t num_tokens = max_length / TX_BUFFER_BYTES_PER_TOKEN + 1;
+    if (num_tokens > MAX_NUMBER_OF_TOKENS) {
+        num_tokens = MAX_NUMBER_OF_TOKENS;
+    }
+    const size_t ram_left = sizeof(arena) - num_tokens * sizeof(jsmntok_t);
+
+    buffer.length = 0;
+    buffer.in_flash = false;
+    buffer.ram_size = max_length < ram_left ? max_length : (uint32_t) ram_left;
+}
+
+bool tx_buffer_move_to_flash(void) {
+    if (buffer.in_flash || buffer.flash == NULL || buffer.length > buffer.flash_size) {
+        return false;
+    }
+
+    if (buffer.length > 0) {
+        MEMCPY_NV(buffer.flash, tx_buffer_ram(), buffer.length);
+    }
+    buffer.in_flash = true;
+    buffer.ram_size = 0;
+    return true;
+}
+
+uint32_t tx_buffer_append(const uint8_t *data, uint32_t length) {
+    if (!buffer.in_flash && length > buffer.ram_size - buffer.length) {
+        // more data than announced in tx_buffer_reset
+        if (!tx_buffer_move_to_flash()) {
+            return 0;
+        }
+    }
+
+    if (buffer.in_flash) {
+        if (buffer.flash == NULL || length > buffer.flash_size - buffer.length) {
+            return 0;
+        }
+        MEMCPY_NV(buffer.flash + buffer.length, (void *) data, length);
+    } else {
+        MEMCPY(tx_buffer_ram() + buffer.length, data, length);
+    }
+
+    buffer.length += length;
+    return length;
+}
+
+bool tx_buffer_in_flash(void) {
+    return buffer.in_flash;
+}
+
+uint8_t *tx_buffer_data(void) {
+    return buffer.in_flash ? buffer.flash : tx_buffer_ram();
+}
+
+uint32_t tx_buffer_length(void) {
+    return buffer.length;
+}
+
+jsmntok_t *tx_buffer_tokens(uint16_t *max_tokens) {
+    size_t num_tokens = (sizeof(arena) - buffer.ram_size) / sizeof(jsmntok_t);
+    if (num_tokens > MAX_NUMBER_OF_TOKENS) {
+        num_tokens = MAX_NUMBER_OF_TOKENS;
+    }
+
+    *max_tokens = (uint16_t) num_tokens;
+    return (jsmntok_t *) arena;
+}
+
+display_item_t *tx_buffer_display_table(uint16_t num_tokens, uint16_t *max_items) {
+    const size_t start = tx_buffer_table_offset(num_tokens);
+    const size_t end = sizeof(arena) - buffer.ram_size;
+
+    size_t num_items = start < end ? (end - start) / sizeof(display_item_t) : 0;
+    if (num_items > MAX_DISPLAY_ITEMS) {
+        num_items = MAX_DISPLAY_ITEMS;
+    }
+
+    *max_items = (uint16_t) num_items;
+    return (display_item_t *) (arena + start);
+}
+
+void tx_buffer_mark(uint16_t num_tokens, uint16_t num_items) {
+    const size_t tx_ram = buffer.in_flash ? 0 : buffer.length;
+    const size_t used = tx_buffer_table_offset(num_tokens) + num_items * sizeof(display_item_t) + tx_ram;
+    if (used > watermark) {
+        watermark = used;
+    }
+}
+
+size_t tx_buffer_watermark(void) {
+    return watermark;
+}
+
+void tx_buffer_watermark_reset(void) {
+    watermark = 0;
+}
@@ -0,0 +1,106 @@
+/*******************************************************************************
+*   (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <jsmn.h>
+#include "json/json_parser.h"
+#include "tx_display.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// RAM the transaction can use when its tokens and display items take all their space
+#if !defined(TX_BUFFER_RAM_SIZE)
+#if defined(TARGET_NANOS)
+#define TX_BUFFER_RAM_SIZE 256
+#else
+#define TX_BUFFER_RAM_SIZE 8192
+#endif
+#endif
+
+// Bytes of json per token expected when keeping RAM for the tokens (at least 2, Binance transactions take about 10)
+#if !defined(TX_BUFFER_BYTES_PER_TOKEN)
+#define TX_BUFFER_BYTES_PER_TOKEN 8
+#endif
+
+// The transaction, its tokens and the display table share a single arena:
+//
+//   | tokens -> | display table | free | transaction |
+//
+// Tokens are stored from the start and the transaction is kept at the end, so the RAM that a small
+// transaction does not use is left to the tokens and the other way around. The display table takes
+// what is left after the last token once the transaction is tokenized.
+// The transaction is moved to flash only when it outgrows its RAM, or when its tokens need that RAM.
+#define TX_BUFFER_ARENA_SIZE (TX_BUFFER_RAM_SIZE + \
+                              MAX_NUMBER_OF_TOKENS * sizeof(jsmntok_t) + \
+                              MAX_DISPLAY_ITEMS * sizeof(display_item_t))
+
+/// Sets the flash region used for transactions that do not fit in RAM
+/// \param flash
+/// \param flash_size
+void tx_buffer_init(uint8_t *flash, uint32_t flash_size);
+
+/// Clears the buffer for a new transaction
+/// \param max_length upper bound of the transaction size, RAM is kept for it and for its expected tokens
+void tx_buffer_reset(uint32_t max_length);
+
+/// Appends data to the transaction. Data beyond max_length moves the transaction to flash
+/// \param data
+/// \param length
+/// \return number of bytes appended (0 if they do not fit)
+uint32_t tx_buffer_append(const uint8_t *data, uint32_t length);
+
+/// Moves the transaction to flash so that its RAM can be used by the tokens
+/// \return false if it was already in flash or does not fit there
+bool tx_buffer_move_to_flash(void);
+
+/// \return true when the transaction is kept in flash
+bool tx_buffer_in_flash(void);
+
+/// \return the transaction received so far
+uint8_t *tx_buffer_data(void);
+
+/// \return size of the transaction received so far
+uint32_t tx_buffer_length(void);
+
+/// Token storage, up to the transaction RAM
+/// \param max_tokens number of tokens that fit (at most MAX_NUMBER_OF_TOKENS)
+/// \return first token
+jsmntok_t *tx_buffer_tokens(uint16_t *max_tokens);
+
+/// Display table storage, after the first num_tokens tokens and up to the transaction RAM
+/// \param num_tokens tokens in use
+/// \param max_items number of items that fit (at most MAX_DISPLAY_ITEMS)
+/// \return first item
+display_item_t *tx_buffer_display_table(uint16_t num_tokens, uint16_t *max_items);
+
+/// Reports the arena used by the tokens, the display table and the transaction kept in RAM
+/// \param num_tokens tokens in use
+/// \param num_items display items in use
+void tx_buffer_mark(uint16_t num_tokens, uint16_t num_items);
+
+/// \return peak arena usage reported by tx_buffer_mark since the last tx_buffer_watermark_reset
+size_t tx_buffer_watermark(void);
+
+void tx_buffer_watermark_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
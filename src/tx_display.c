@@ -13,20 +13,14 @@
 *  See the License for the specific language governing permissions and
 *  limitations under the License.
 ********************************************************************************/
-#ifdef __cplusplus
-#pragma clang diagnostic push
-#pragma ide diagnostic ignored "misc-no-recursion"
-#endif
-
 #include "coin.h"
 #include "app_mode.h"
 #include "tx_display.h"
 #include "tx_parser.h"
 #include "parser_impl.h"
+#include "tx_buffer.h"
 #include <zxmacros.h>
 
-#define NUM_REQUIRED_ROOT_PAGES 7
-
 const char *get_required_root_item(root_item_e i) {
     switch (i) {
         case root_item_chain_id:
@@ -48,6 +42,27 @@ const char *get_required_root_item(root_item_e i) {
     }
 }
 
+__Z_INLINE key_id_e get_root_key_id(root_item_e i) {
+    switch (i) {
+        case root_item_chain_id:
+            return key_chain_id;
+        case root_item_account_number:
+            return key_account_number;
+        case root_item_sequence:
+            return key_sequence;
+        case root_item_memo:
+            return key_memo;
+        case root_item_msgs:
+            return key_msgs;
+        case root_item_source:
+            return key_source;
+        case root_item_data:
+            return key_data;
+        default:
+            return key_unknown;
+    }
+}
+
 #ifdef __cplusplus
 #pragma clang diagnostic push
 #pragma ide diagnostic ignored "bugprone-branch-clone"
@@ -81,53 +96,76 @@ typedef struct {
     // total items
     uint16_t total_item_count;
     // number of items the root_item contains
-    uint8_t root_item_number_subitems[NUM_REQUIRED_ROOT_PAGES];
-
-    uint8_t is_default_chain;
+    uint16_t root_item_number_subitems[NUM_REQUIRED_ROOT_PAGES];
+
+    // Visible items in display order. Grouped fields that are hidden are not listed.
+    // It depends on expert mode, so it is built again when the mode changes.
+    bool table_valid;
+    bool table_expert_mode;
+    uint16_t num_items;
+    // display index of the first item of each root item, the last entry is the number of items
+    uint16_t root_item_display_start[NUM_REQUIRED_ROOT_PAGES + 1];
+    uint16_t table_count;
+    // the table is kept in the tx buffer arena, after the tokens
+    display_item_t *table;
+    uint16_t table_capacity;
 } display_cache_t;
 
 display_cache_t display_cache;
 
-parser_error_t tx_display_readTx(parser_context_t *ctx, const uint8_t *data, size_t dataLen) {
-    CHECK_PARSER_ERR(parser_init(ctx, data, dataLen))
-    CHECK_PARSER_ERR(_readTx(ctx, &parser_tx_obj))
-    return parser_ok;
-}
+// Walk over the visible items of a root item, in the same order as tx_traverse_find finds them.
+// Fields are recognized by their known path, the key is only written for the items that are shown
+typedef struct {
+    tx_traversal_t traversal;
+    root_item_e root_item;
+    // leaves visited in the root item, including hidden ones (as query._item_index_current)
+    uint16_t item_index_current;
+} display_walk_t;
 
-__Z_INLINE parser_error_t calculate_is_default_chainid() {
-    display_cache.is_default_chain = false;
-
-    // get chain_id
-    char outKey[2];
-    char outVal[COIN_MAX_CHAINID_LEN];
-    uint8_t pageCount;
-    INIT_QUERY_CONTEXT(outKey, sizeof(outKey),
-                       outVal, sizeof(outVal),
-                       0, get_root_max_level(root_item_chain_id))
-    parser_tx_obj.query.item_index = 0;
-    parser_tx_obj.query._item_index_current = 0;
+// Last item found by tx_display_cursor_query. The walk stays right after it, so the next item is found from there
+typedef struct {
+    bool valid;
+    display_walk_t walk;
+    display_item_t item;
+    // display index of the next item of the walk
+    uint16_t next_display_idx;
+    // first display index after the root item of the walk
+    uint16_t root_end_display_idx;
+} display_cursor_t;
+
+// The walk is shared with display_table_build, that invalidates the cursor
+static display_cursor_t display_cursor;
+
+__Z_INLINE void display_walk_start(display_walk_t *walk, root_item_e root_item) {
+    walk->root_item = root_item;
+    walk->item_index_current = 0;
+
+    tx_traverse_start(&walk->traversal,
+                      display_cache.root_item_start_token_idx[root_item], get_root_key_id(root_item),
+                      get_root_max_level(root_item), MAX_TRAVERSAL_DEPTH,
+                      NULL, 0);
+}
 
-    uint16_t ret_value_token_index;
-    CHECK_PARSER_ERR(tx_traverse_find(
-            display_cache.root_item_start_token_idx[root_item_chain_id],
-            &ret_value_token_index))
-
-    CHECK_PARSER_ERR(tx_getToken(
-            ret_value_token_index,
-            outVal, sizeof(outVal),
-            0, &pageCount))
-
-    zemu_log_stack(outVal);
-    zemu_log_stack(COIN_DEFAULT_CHAINID);
-
-    if (strcmp(outVal, COIN_DEFAULT_CHAINID) == 0) {
-        // If we don't match the default chainid, switch to expert mode
-        display_cache.is_default_chain = true;
-        zemu_log_stack("DEFAULT Chain ");
-    } else {
-        zemu_log_stack("Chain is NOT DEFAULT");
+__Z_INLINE parser_error_t display_walk_next(display_walk_t *walk, display_item_t *item) {
+    uint16_t leaf_token_idx;
+    bool hidden = true;
+    while (hidden) {
+        CHECK_PARSER_ERR(tx_traverse_next(&walk->traversal, &leaf_token_idx))
+        hidden = tx_is_grouped_field(walk->traversal.key_id, walk->item_index_current);
+        walk->item_index_current++;
     }
 
+    item->value_token_idx = leaf_token_idx;
+    item->root_item = walk->root_item;
+    item->key_id = walk->traversal.key_id;
+    item->key_token_idx = 0;
+    item->num_keys = tx_traverse_keys(&walk->traversal, &item->key_token_idx);
+    return parser_ok;
+}
+
+parser_error_t tx_display_readTx(parser_context_t *ctx, const uint8_t *data, size_t dataLen) {
+    CHECK_PARSER_ERR(parser_init(ctx, data, dataLen))
+    CHECK_PARSER_ERR(_readTx(ctx, &parser_tx_obj))
     return parser_ok;
 }
 
@@ -146,6 +184,11 @@ parser_error_t tx_indexRootFields() {
         return parser_ok;
     }
 
+    // The root items are found by tx_validate, the tx can not be shown before it is validated
+    if (!parser_tx_obj.root_slots.valid) {
+        return parser_unexpected_error;
+    }
+
 #ifdef APP_TESTING
     zemu_log("tx_indexRootFields");
 #endif
@@ -153,9 +196,11 @@ parser_error_t tx_indexRootFields() {
     // Clear cache
     MEMZERO(&display_cache, sizeof(display_cache_t));
 
-    char tmp_key[INDEXING_TMP_KEYSIZE];
+    // The walk is shared with the cursor
+    display_walk_t *walk = &display_cursor.walk;
+    display_cursor.valid = false;
+
     char tmp_val[INDEXING_TMP_VALUESIZE];
-    MEMZERO(&tmp_key, sizeof(tmp_key));
     MEMZERO(&tmp_val, sizeof(tmp_val));
 
     // Grouping references
@@ -169,61 +214,32 @@ parser_error_t tx_indexRootFields() {
     parser_tx_obj.flags.msg_type_grouping = 1;
     parser_tx_obj.flags.msg_from_grouping = 1;
 
-    // Look for all expected root items in the JSON tree
-    // mark them as found/valid,
-
     for (root_item_e root_item_idx = 0; root_item_idx < NUM_REQUIRED_ROOT_PAGES; root_item_idx++) {
-        uint16_t req_root_item_key_token_idx = 0;
-
-        const char *required_root_item_key = get_required_root_item(root_item_idx);
-
-        parser_error_t err = object_get_value(
-                &parser_tx_obj.json,
-                ROOT_TOKEN_INDEX,
-                required_root_item_key,
-                &req_root_item_key_token_idx);
-
-        if (err == parser_no_data) {
+        const uint16_t req_root_item_key_token_idx = parser_tx_obj.root_slots.value_token[root_item_idx];
+        if (req_root_item_key_token_idx == 0) {
             continue;
         }
-        CHECK_PARSER_ERR(err)
 
         // Remember root item start token
         display_cache.root_item_start_token_valid[root_item_idx] = true;
         display_cache.root_item_start_token_idx[root_item_idx] = req_root_item_key_token_idx;
 
-        // Now count how many items can be found in this root item
-        int16_t current_item_idx = 0;
-        while (err == parser_ok) {
-            INIT_QUERY_CONTEXT(tmp_key, sizeof(tmp_key),
-                               tmp_val, sizeof(tmp_val),
-                               0, get_root_max_level(root_item_idx))
+        parser_error_t err;
 
-            parser_tx_obj.query.item_index = current_item_idx;
-            strncpy_s(parser_tx_obj.query.out_key,
-                      required_root_item_key,
-                      parser_tx_obj.query.out_key_len);
+        // Now count how many items can be found in this root item, visiting its leaves once
+        display_walk_start(walk, root_item_idx);
 
-            uint16_t ret_value_token_index;
-            err = tx_traverse_find(display_cache.root_item_start_token_idx[root_item_idx], &ret_value_token_index);
-            if (err != parser_ok) {
-                continue;
-            }
-
-            uint8_t pageCount;
-            CHECK_PARSER_ERR(tx_getToken(
-                    ret_value_token_index,
-                    parser_tx_obj.query.out_val,
-                    parser_tx_obj.query.out_val_len,
-                    0, &pageCount))
-
-            ZEMU_LOGF(200, "[ZEMU] %s : %s", tmp_key, parser_tx_obj.query.out_val)
+        display_item_t item;
+        while ((err = display_walk_next(walk, &item)) == parser_ok) {
+            // position of the leaf in the root item (nothing is hidden while indexing)
+            const int32_t current_item_idx = (int32_t) walk->item_index_current - 1;
 
             switch (root_item_idx) {
                 case root_item_memo: {
-                    if (strlen(parser_tx_obj.query.out_val) == 0) {
+                    uint8_t pageCount;
+                    CHECK_PARSER_ERR(tx_getToken(item.value_token_idx, tmp_val, sizeof(tmp_val), 0, &pageCount))
+                    if (strlen(tmp_val) == 0) {
                         err = parser_query_no_results;
-                        continue;
                     }
                     break;
                 }
@@ -231,9 +247,20 @@ parser_error_t tx_indexRootFields() {
                     // Note: if we are dealing with the message field, Ledger has requested that we group.
                     // This means that if all messages share the same time, we should only count the type field once
                     // This is indicated by `parser_tx_obj.flags.msg_type_grouping`
+                    const bool is_type = parser_tx_obj.flags.msg_type_grouping && item.key_id == key_msgs_type;
+                    const bool is_from = parser_tx_obj.flags.msg_from_grouping &&
+                                         item.key_id == key_msgs_value_delegator_address;
+                    if (!is_type && !is_from) {
+                        break;
+                    }
+
+                    // Only grouping fields need their value
+                    uint8_t pageCount;
+                    CHECK_PARSER_ERR(tx_getToken(item.value_token_idx, tmp_val, sizeof(tmp_val), 0, &pageCount))
+                    ZEMU_LOGF(200, "[ZEMU] key %d : %s", item.key_id, tmp_val)
 
                     // GROUPING: Message Type
-                    if (parser_tx_obj.flags.msg_type_grouping && is_msg_type_field(tmp_key)) {
+                    if (is_type) {
                         // First message, initialize expected type
                         if (parser_tx_obj.filter_msg_type_count == 0) {
 
@@ -255,7 +282,7 @@ parser_error_t tx_indexRootFields() {
                     }
 
                     // GROUPING: Message From
-                    if (parser_tx_obj.flags.msg_from_grouping && is_msg_from_field(tmp_key)) {
+                    if (is_from) {
                         // First message, initialize expected from
                         if (parser_tx_obj.filter_msg_from_count == 0) {
                             snprintf(reference_msg_from, sizeof(reference_msg_from), "%s", tmp_val);
@@ -271,28 +298,35 @@ parser_error_t tx_indexRootFields() {
                         parser_tx_obj.filter_msg_from_count++;
                     }
 
-                    ZEMU_LOGF(200, "[ZEMU] %s [%d/%d]", tmp_key, parser_tx_obj.filter_msg_type_count, parser_tx_obj.filter_msg_from_count);
+                    ZEMU_LOGF(200, "[ZEMU] key %d [%d/%d]", item.key_id, parser_tx_obj.filter_msg_type_count, parser_tx_obj.filter_msg_from_count);
                     break;
                 }
                 default:
                     break;
             }
 
+            if (err != parser_ok) {
+                break;
+            }
+
+            if (display_cache.root_item_number_subitems[root_item_idx] == UINT16_MAX) {
+                return parser_display_too_many_items;
+            }
             display_cache.root_item_number_subitems[root_item_idx]++;
-            current_item_idx++;
         }
 
         if (err != parser_query_no_results && err != parser_no_data) {
             return err;
         }
 
+        if (display_cache.root_item_number_subitems[root_item_idx] > UINT16_MAX - display_cache.total_item_count) {
+            return parser_display_too_many_items;
+        }
         display_cache.total_item_count += display_cache.root_item_number_subitems[root_item_idx];
     }
 
     parser_tx_obj.flags.cache_valid = 1;
 
-    CHECK_PARSER_ERR(calculate_is_default_chainid())
-
     // turn off grouping if we are not in expert mode
     if (tx_is_expert_mode()) {
         parser_tx_obj.flags.msg_from_grouping = 0;
@@ -309,14 +343,14 @@ parser_error_t tx_indexRootFields() {
 
 __Z_INLINE bool is_default_chainid() {
     CHECK_PARSER_ERR(tx_indexRootFields())
-    return display_cache.is_default_chain;
+    return parser_tx_obj.root_slots.is_default_chain;
 }
 
 bool tx_is_expert_mode() {
     return app_mode_expert() || !is_default_chainid();
 }
 
-__Z_INLINE uint8_t get_subitem_count(root_item_e root_item) {
+__Z_INLINE uint16_t get_subitem_count(root_item_e root_item) {
     CHECK_PARSER_ERR(tx_indexRootFields())
     if (display_cache.total_item_count == 0)
         return 0;
@@ -356,62 +390,214 @@ __Z_INLINE uint8_t get_subitem_count(root_item_e root_item) {
     return tmp_num_items;
 }
 
-__Z_INLINE parser_error_t retrieve_tree_indexes(uint8_t display_index, root_item_e *root_item, uint8_t *subitem_index) {
-    // Find root index | display_index idx -> item_index
-    // consume indexed subpages until we get the item index in the subpage
-    *root_item = 0;
-    *subitem_index = 0;
-    while (get_subitem_count(*root_item) == 0) {
-        (*root_item)++;
+// Root item that shows displayIdx, and the position of the item in it (from the table prefix sums)
+__Z_INLINE parser_error_t retrieve_tree_indexes(uint16_t display_index, root_item_e *root_item, uint16_t *subitem_index) {
+    if (display_index >= display_cache.root_item_display_start[NUM_REQUIRED_ROOT_PAGES]) {
+        return parser_display_idx_out_of_range;
+    }
+
+    // last root item that starts at or before display_index, it can not be empty
+    root_item_e r = NUM_REQUIRED_ROOT_PAGES - 1;
+    while (display_cache.root_item_display_start[r] > display_index) {
+        r--;
+    }
+
+    *root_item = r;
+    *subitem_index = display_index - display_cache.root_item_display_start[r];
+    return parser_ok;
+}
+
+__Z_INLINE void display_item_key(const display_item_t *item, char *outKey, uint16_t outKeyLen) {
+    MEMZERO(outKey, outKeyLen);
+    strncpy_s(outKey, get_required_root_item(item->root_item), outKeyLen);
+    parser_tx_obj.query.out_key = outKey;
+    parser_tx_obj.query.out_key_len = outKeyLen;
+    if (item->num_keys > 0) {
+        tx_append_key_item(item->key_token_idx);
+    }
+    if (item->num_keys > 1) {
+        tx_append_key_item(item->value_token_idx - 1);
+    }
+}
+
+__Z_INLINE parser_error_t display_table_build(bool expert_mode) {
+    display_cache.table_valid = false;
+    display_cache.table_count = 0;
+    display_cache.num_items = 0;
+    display_cursor.valid = false;
+    display_cache.table = tx_buffer_display_table(json_tokens_in_use(&parser_tx_obj.json),
+                                                  &display_cache.table_capacity);
+
+    display_walk_t *walk = &display_cursor.walk;
+    bool table_aligned = true;
+
+    uint16_t display_start = 0;
+    for (root_item_e root_item = 0; root_item < NUM_REQUIRED_ROOT_PAGES; root_item++) {
+        display_cache.root_item_display_start[root_item] = display_start;
+        display_start += get_subitem_count(root_item);
     }
+    display_cache.root_item_display_start[NUM_REQUIRED_ROOT_PAGES] = display_start;
+    display_cache.num_items = display_start;
+
+    for (root_item_e root_item = 0; root_item < NUM_REQUIRED_ROOT_PAGES; root_item++) {
+        const uint16_t subitem_count = display_cache.root_item_display_start[root_item + 1] -
+                                       display_cache.root_item_display_start[root_item];
+
+        if (subitem_count == 0 || !table_aligned || !display_cache.root_item_start_token_valid[root_item]) {
+            continue;
+        }
 
-    for (uint16_t i = 0; i < display_index; i++) {
-        (*subitem_index)++;
-        const uint8_t subitem_count = get_subitem_count(*root_item);
-        if (*subitem_index >= subitem_count) {
-            // Advance root index and skip empty items
-            *subitem_index = 0;
-            (*root_item)++;
-            while (get_subitem_count(*root_item) == 0) {
-                (*root_item)++;
+        display_walk_start(walk, root_item);
+        for (uint16_t i = 0; i < subitem_count; i++) {
+            display_item_t item;
+            if (display_walk_next(walk, &item) != parser_ok) {
+                // Items that could not be listed are left to the cursor, and so are all the items after them
+                table_aligned = false;
+                break;
             }
+            if (display_cache.table_count >= display_cache.table_capacity) {
+                table_aligned = false;
+                break;
+            }
+            display_cache.table[display_cache.table_count++] = item;
         }
     }
 
-    if (*root_item > NUM_REQUIRED_ROOT_PAGES) {
-        return parser_no_data;
-    }
+    tx_buffer_mark(json_tokens_in_use(&parser_tx_obj.json), display_cache.table_count);
 
+    display_cache.table_expert_mode = expert_mode;
+    display_cache.table_valid = true;
     return parser_ok;
 }
 
-parser_error_t tx_display_numItems(uint8_t *num_items) {
-    *num_items = 0;
+__Z_INLINE parser_error_t display_table_update() {
     CHECK_PARSER_ERR(tx_indexRootFields())
 
-    *num_items = 0;
-    for (root_item_e root_item = 0; root_item < NUM_REQUIRED_ROOT_PAGES; root_item++) {
-        *num_items += get_subitem_count(root_item);
+    const bool expert_mode = tx_is_expert_mode();
+    if (display_cache.table_valid && display_cache.table_expert_mode == expert_mode) {
+        return parser_ok;
     }
 
+    return display_table_build(expert_mode);
+}
+
+parser_error_t tx_display_numItems(uint16_t *num_items) {
+    *num_items = 0;
+    CHECK_PARSER_ERR(display_table_update())
+
+    *num_items = display_cache.num_items;
     return parser_ok;
 }
 
-// This function assumes that the tx_ctx has been set properly
 parser_error_t tx_display_query(uint16_t displayIdx,
                                 char *outKey, uint16_t outKeyLen,
-                                uint16_t *ret_value_token_index) {
-    CHECK_PARSER_ERR(tx_indexRootFields())
+                                uint16_t *ret_value_token_index, key_id_e *ret_key_id) {
+    CHECK_PARSER_ERR(display_table_update())
+
+    if (displayIdx >= display_cache.num_items) {
+        return parser_display_idx_out_of_range;
+    }
+
+    if (displayIdx >= display_cache.table_count) {
+        return tx_display_cursor_query(displayIdx, outKey, outKeyLen, ret_value_token_index, ret_key_id);
+    }
+
+    const display_item_t *item = &display_cache.table[displayIdx];
+    display_item_key(item, outKey, outKeyLen);
+
+    *ret_value_token_index = item->value_token_idx;
+    *ret_key_id = (key_id_e) item->key_id;
+    return parser_ok;
+}
+
+// Restarts the cursor at the first item of the root item that contains displayIdx
+__Z_INLINE parser_error_t display_cursor_seek(uint16_t displayIdx) {
+    display_cursor.valid = false;
+
+    root_item_e root_item = 0;
+    uint16_t subitem_index = 0;
+    CHECK_PARSER_ERR(retrieve_tree_indexes(displayIdx, &root_item, &subitem_index))
+
+    if (!display_cache.root_item_start_token_valid[root_item]) {
+        return parser_no_data;
+    }
+
+    display_walk_start(&display_cursor.walk, root_item);
+    display_cursor.next_display_idx = display_cache.root_item_display_start[root_item];
+    display_cursor.root_end_display_idx = display_cache.root_item_display_start[root_item + 1];
+    display_cursor.valid = true;
+    return parser_ok;
+}
+
+// Moves the cursor to displayIdx (it must be in range)
+__Z_INLINE parser_error_t display_cursor_move(uint16_t displayIdx) {
+    // Items behind the cursor or in another root item need a seek, the rest resume from the last item
+    if (!display_cursor.valid ||
+        displayIdx + 1 < display_cursor.next_display_idx ||
+        displayIdx >= display_cursor.root_end_display_idx) {
+        CHECK_PARSER_ERR(display_cursor_seek(displayIdx))
+    }
+
+    while (display_cursor.next_display_idx <= displayIdx) {
+        const parser_error_t err = display_walk_next(&display_cursor.walk, &display_cursor.item);
+        if (err != parser_ok) {
+            display_cursor.valid = false;
+            return err;
+        }
+        display_cursor.next_display_idx++;
+    }
 
-    uint8_t num_items;
-    CHECK_PARSER_ERR(tx_display_numItems(&num_items))
+    return parser_ok;
+}
+
+parser_error_t tx_display_cursor_query(uint16_t displayIdx,
+                                       char *outKey, uint16_t outKeyLen,
+                                       uint16_t *ret_value_token_index, key_id_e *ret_key_id) {
+    CHECK_PARSER_ERR(display_table_update())
+
+    if (displayIdx >= display_cache.num_items) {
+        return parser_display_idx_out_of_range;
+    }
+
+    CHECK_PARSER_ERR(display_cursor_move(displayIdx))
+
+    display_item_key(&display_cursor.item, outKey, outKeyLen);
+    *ret_value_token_index = display_cursor.item.value_token_idx;
+    *ret_key_id = (key_id_e) display_cursor.item.key_id;
+    return parser_ok;
+}
+
+parser_error_t tx_display_walk_start(uint16_t *num_items) {
+    *num_items = 0;
+    CHECK_PARSER_ERR(display_table_update())
 
-    if (displayIdx < 0 || displayIdx >= num_items) {
+    display_cursor.valid = false;
+    *num_items = display_cache.num_items;
+    return parser_ok;
+}
+
+parser_error_t tx_display_walk_next(uint16_t *ret_value_token_index, key_id_e *ret_key_id) {
+    const uint16_t displayIdx = display_cursor.valid ? display_cursor.next_display_idx : 0;
+    if (displayIdx >= display_cache.num_items) {
         return parser_display_idx_out_of_range;
     }
 
+    CHECK_PARSER_ERR(display_cursor_move(displayIdx))
+
+    *ret_value_token_index = display_cursor.item.value_token_idx;
+    *ret_key_id = (key_id_e) display_cursor.item.key_id;
+    return parser_ok;
+}
+
+#if defined(TX_REFERENCE_SEARCH)
+// This function assumes that the tx_ctx has been set properly
+parser_error_t tx_display_find(uint16_t displayIdx,
+                               char *outKey, uint16_t outKeyLen,
+                               uint16_t *ret_value_token_index, key_id_e *ret_key_id) {
+    CHECK_PARSER_ERR(display_table_update())
+
     root_item_e root_index = 0;
-    uint8_t subitem_index = 0;
+    uint16_t subitem_index = 0;
     CHECK_PARSER_ERR(retrieve_tree_indexes(displayIdx, &root_index, &subitem_index))
 
     // Prepare query
@@ -431,8 +617,10 @@ parser_error_t tx_display_query(uint16_t displayIdx,
             display_cache.root_item_start_token_idx[root_index],
             ret_value_token_index))
 
+    *ret_key_id = (key_id_e) parser_tx_obj.query.out_key_id;
     return parser_ok;
 }
+#endif
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -448,71 +636,21 @@ parser_error_t tx_display_query(uint16_t displayIdx,
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 
-static const key_subst_t key_substitutions[] = {
-        {"chain_id",                          "Chain ID"},
-        {"account_number",                    "Account"},
-        {"sequence",                          "Sequence"},
-        {"memo",                              "Memo"},
-        {"source",                            "Source"},
-        {"data",                              "Data"},
-
-        {"msgs/inputs/address",               "Send from"},
-        {"msgs/inputs/coins",                 "Send input coins"},
-        {"msgs/outputs/address",              "Send to"},
-        {"msgs/outputs/coins",                "Send output coins"},
-
-        {"msgs/voting_period",                "Voting period (in ns)"},
-        {"msgs/refid",                        "Cancel order ID"},
-        {"msgs/timeinforce",                  "Time in force"},
-        {"msgs/ordertype",                    "Create order type"},
-        {"msgs/id",                           "Create order ID"},
-        {"msgs/side",                         "Side"},
-        {"msgs/price",                        "Price"},
-        {"msgs/quantity",                     "Quantity"},
-        {"msgs/sender",                       "Sender"},
-        {"msgs/symbol",                       "Symbol"},
-        
-};
-
-parser_error_t tx_display_make_friendly(char* out_key, uint16_t out_key_len, char* out_value, uint16_t out_value_len) {
+parser_error_t tx_display_make_friendly(key_id_e key_id,
+                                        char *out_key, uint16_t out_key_len,
+                                        char *out_value, uint16_t out_value_len) {
     CHECK_PARSER_ERR(tx_indexRootFields())
 
-    if (strcmp(out_key, "msgs/ordertype") == 0) {
-        if (strcmp(out_value, "1") == 0) {
-            strncpy(out_value, "Market order", out_value_len);
-        }
-        else if (strcmp(out_value, "2") == 0) {
-            strncpy(out_value, "Limit order", out_value_len);
-        }
-    }
-    else if (strcmp(out_key, "msgs/side") == 0) {
-        if (strcmp(out_value, "1") == 0) {
-            strncpy(out_value, "Buy", out_value_len);
-        }
-        else if (strcmp(out_value, "2") == 0) {
-            strncpy(out_value, "Sell", out_value_len);
-        }
-    }
-    else if (strcmp(out_key, "msgs/timeinforce") == 0) {
-        if (strcmp(out_value, "1") == 0) {
-            strncpy(out_value, "Good 'Til Expiry", out_value_len);
-        }
-        else if (strcmp(out_value, "3") == 0) {
-            strncpy(out_value, "Immediate or Cancel", out_value_len);
-        }
+    // Labels come from known_keys.spec
+    const char *value_label = known_key_value_label(key_id, out_value);
+    if (value_label != NULL) {
+        strncpy_s(out_value, value_label, out_value_len);
     }
 
-    // post process keys
-    for (size_t i = 0; i < array_length(key_substitutions); i++) {
-        if (!strcmp(out_key, key_substitutions[i].str1)) {
-            strncpy_s(out_key, key_substitutions[i].str2, out_key_len);
-            break;
-        }
+    const char *key_label = known_key_label(key_id);
+    if (out_key != NULL && key_label != NULL) {
+        strncpy_s(out_key, key_label, out_key_len);
     }
 
     return parser_ok;
 }
-
-#ifdef __cplusplus
-#pragma clang diagnostic pop
-#endif
@@ -19,6 +19,7 @@
 #include <stdint.h>
 #include <common/parser_common.h>
 #include "parser_txdef.h"
+#include "tx_parser.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -43,20 +44,90 @@ typedef enum {
     root_item_data,
 } root_item_e;
 
+// Items that fit in the display table. Items beyond are found by traversing the tree
+#if !defined(MAX_DISPLAY_ITEMS)
+#if defined(TARGET_NANOS)
+#define MAX_DISPLAY_ITEMS 32
+#else
+#define MAX_DISPLAY_ITEMS 255
+#endif
+#endif
+
+// A visible item: value token and the keys that lead to it from the root item.
+// Root items go at most 2 levels deep (see get_root_max_level). The second key always
+// takes the last level, so it is the token right before the value.
+typedef struct {
+    uint16_t value_token_idx;
+    // first key below the root item (when num_keys > 0)
+    uint16_t key_token_idx;
+    uint8_t root_item: 3;
+    uint8_t num_keys: 2;
+    // known path of the key (key_id_e)
+    uint8_t key_id;
+} display_item_t;
+
 bool tx_is_expert_mode();
 
 const char *get_required_root_item(root_item_e i);
 
+/// Get the key and value token of a display item (from the display table)
+/// \param displayIdx
+/// \param outKey
+/// \param outKeyLen
+/// \param ret_value_token_index
+/// \param ret_key_id known path of the key (key_unknown for other keys)
+/// \return Error message
 parser_error_t tx_display_query(uint16_t displayIdx,
                                 char *outKey, uint16_t outKeyLen,
-                                uint16_t *ret_value_token_index);
+                                uint16_t *ret_value_token_index, key_id_e *ret_key_id);
+
+/// Same as tx_display_query, but walking the tree from the last item found.
+/// The next item (or the same one, for another page) resumes from there; other items seek from their root item.
+/// Used for items that do not fit in the display table
+/// \param displayIdx
+/// \param outKey
+/// \param outKeyLen
+/// \param ret_value_token_index
+/// \param ret_key_id
+/// \return Error message
+parser_error_t tx_display_cursor_query(uint16_t displayIdx,
+                                       char *outKey, uint16_t outKeyLen,
+                                       uint16_t *ret_value_token_index, key_id_e *ret_key_id);
+
+/// Starts a walk over all the display items, in display order. Each item is found once
+/// \param num_items number of items the walk returns
+/// \return Error message
+parser_error_t tx_display_walk_start(uint16_t *num_items);
+
+/// Next item of the walk started by tx_display_walk_start, without its key
+/// (the display state must not change during the walk, it is not checked again)
+/// \param ret_value_token_index
+/// \param ret_key_id
+/// \return Error message
+parser_error_t tx_display_walk_next(uint16_t *ret_value_token_index, key_id_e *ret_key_id);
+
+#if defined(TX_REFERENCE_SEARCH)
+/// Same as tx_display_query, but searching the item by traversing the tree from its root item
+parser_error_t tx_display_find(uint16_t displayIdx,
+                               char *outKey, uint16_t outKeyLen,
+                               uint16_t *ret_value_token_index, key_id_e *ret_key_id);
+#endif
 
 parser_error_t tx_display_readTx(parser_context_t *c,
                                  const uint8_t *data, size_t dataLen);
 
-parser_error_t tx_display_numItems(uint8_t *num_items);
+parser_error_t tx_display_numItems(uint16_t *num_items);
 
-parser_error_t tx_display_make_friendly(char* out_key, uint16_t out_key_len, char* out_value, uint16_t out_value_len);
+/// Replaces known values, and the key of known paths by its label
+/// \param key_id known path of the item
+/// \param out_key key to replace, it can be NULL when only the value is needed
+/// \param out_key_len
+/// \param out_value
+/// \param out_value_len
+/// \return Error message
+parser_error_t tx_display_make_friendly(key_id_e key_id,
+                                        char *out_key, uint16_t out_key_len,
+                                        char *out_value, uint16_t out_value_len);
 
 //---------------------------------------------
 
@@ -13,11 +13,6 @@
 *  See the License for the specific language governing permissions and
 *  limitations under the License.
 ********************************************************************************/
-#ifdef __cplusplus
-#pragma clang diagnostic push
-#pragma ide diagnostic ignored "misc-no-recursion"
-#endif
-
 #include <jsmn.h>
 #include "tx_parser.h"
 #include "zxmacros.h"
@@ -58,8 +53,9 @@ parser_error_t tx_getToken(uint16_t token_index,
     *pageCount = 0;
     MEMZERO(out_val, out_val_len);
 
-    const int16_t token_start = parser_tx_obj.json.tokens[token_index].start;
-    const int16_t token_end = parser_tx_obj.json.tokens[token_index].end;
+    const jsmntok_t token = json_token(&parser_tx_obj.json, token_index);
+    const uint16_t token_start = token.start;
+    const uint16_t token_end = token.end;
 
     if (token_start > token_end) {
         return parser_unexpected_buffer_end;
@@ -68,6 +64,11 @@ parser_error_t tx_getToken(uint16_t token_index,
     const char *inValue = parser_tx_obj.tx + token_start;
     uint16_t inLen = token_end - token_start;
 
+    // pages are counted in a uint8_t
+    if (out_val_len > 1 && (inLen + out_val_len - 2) / (out_val_len - 1) > UINT8_MAX) {
+        return parser_display_too_many_pages;
+    }
+
     // empty strings are considered the first page
     *pageCount = 1;
     if (inLen > 0) {
@@ -81,7 +82,7 @@ parser_error_t tx_getToken(uint16_t token_index,
     return parser_ok;
 }
 
-__Z_INLINE void append_key_item(uint16_t token_index) {
+void tx_append_key_item(uint16_t token_index) {
     if (*parser_tx_obj.query.out_key > 0) {
         // There is already something there, add separator
         strcat_chunk_s(parser_tx_obj.query.out_key,
@@ -90,8 +91,9 @@ __Z_INLINE void append_key_item(uint16_t token_index) {
                        1);
     }
 
-    const int16_t token_start = parser_tx_obj.json.tokens[token_index].start;
-    const int16_t token_end = parser_tx_obj.json.tokens[token_index].end;
+    const jsmntok_t token = json_token(&parser_tx_obj.json, token_index);
+    const uint16_t token_start = token.start;
+    const uint16_t token_end = token.end;
     const char *address_ptr = parser_tx_obj.tx + token_start;
     const int32_t new_item_size = token_end - token_start;
 
@@ -107,121 +109,198 @@ __Z_INLINE void append_key_item(uint16_t token_index) {
 ///////////////////////////
 ///////////////////////////
 
-parser_error_t tx_traverse_find(uint16_t root_token_index, uint16_t *ret_value_token_index) {
-    const jsmntype_t token_type = parser_tx_obj.json.tokens[root_token_index].type;
+key_id_e tx_key_child(key_id_e parent, uint16_t key_token_index) {
+    if (parent == key_unknown) {
+        return key_unknown;
+    }
 
-    CHECK_APP_CANARY()
+    const jsmntok_t token = json_token(&parser_tx_obj.json, key_token_index);
+    return known_key_find(parent, parser_tx_obj.tx + token.start, token.end - token.start);
+}
 
-    if (parser_tx_obj.tx == NULL || root_token_index < 0) {
-        return parser_no_data;
+bool tx_is_grouped_field(key_id_e key_id, uint16_t item_index) {
+    const bool skipTypeField =
+            parser_tx_obj.flags.cache_valid &&
+            parser_tx_obj.flags.msg_type_grouping &&
+            key_id == key_msgs_type &&
+            parser_tx_obj.filter_msg_type_valid_idx != item_index;
+
+    const bool skipFromFieldHidingRule =
+            parser_tx_obj.flags.msg_from_grouping_hide_all ||
+            parser_tx_obj.filter_msg_from_valid_idx != item_index;
+
+    const bool skipFromField =
+            parser_tx_obj.flags.cache_valid &&
+            parser_tx_obj.flags.msg_from_grouping &&
+            key_id == key_msgs_value_delegator_address &&
+            skipFromFieldHidingRule;
+
+    return skipFromField || skipTypeField;
+}
+
+// Returns true if token_index is a leaf, otherwise it is pushed so that its children are walked next
+__Z_INLINE bool traverse_enter(tx_traversal_t *t, uint16_t token_index, uint8_t key_id, uint8_t level, uint8_t depth) {
+    const jsmntype_t token_type = json_token(&parser_tx_obj.json, token_index).type;
+
+    if (level == 0 || depth == 0 || token_type == JSMN_STRING || token_type == JSMN_PRIMITIVE) {
+        t->key_id = key_id;
+        return true;
     }
 
-    if (parser_tx_obj.query.max_level <= 0 || parser_tx_obj.query.max_depth <= 0 ||
-        token_type == JSMN_STRING ||
-        token_type == JSMN_PRIMITIVE) {
-        const bool skipTypeField =
-                parser_tx_obj.flags.cache_valid &&
-                parser_tx_obj.flags.msg_type_grouping &&
-                is_msg_type_field(parser_tx_obj.query.out_key) &&
-                parser_tx_obj.filter_msg_type_valid_idx != parser_tx_obj.query._item_index_current;
+    tx_traverse_frame_t *frame = &t->frames[t->num_frames++];
+    frame->child = json_first_child(&parser_tx_obj.json, token_index);
+    frame->end = json_next_sibling(&parser_tx_obj.json, token_index);
+    frame->level = level;
+    frame->is_object = token_type == JSMN_OBJECT;
+    frame->path_id = key_id;
+    frame->key_id = key_id;
+    if (frame->is_object && t->out_key != NULL) {
+        frame->key = 0;
+        frame->key_len = (uint16_t) strlen(t->out_key);
+    }
+    return false;
+}
 
-        const bool skipFromFieldHidingRule =
-                parser_tx_obj.flags.msg_from_grouping_hide_all ||
-                parser_tx_obj.filter_msg_from_valid_idx != parser_tx_obj.query._item_index_current;
+// Replaces the last key of out_key, as tx_append_key_item after truncating out_key to key_len
+__Z_INLINE void traverse_set_key(tx_traversal_t *t, uint16_t key_len, uint16_t key_token_index) {
+    char *out_key = t->out_key;
+    const uint16_t max_len = t->out_key_len - 1;  // -1 because requires termination
 
-        const bool skipFromField =
-                parser_tx_obj.flags.cache_valid &&
-                parser_tx_obj.flags.msg_from_grouping &&
-                is_msg_from_field(parser_tx_obj.query.out_key) &&
-                skipFromFieldHidingRule;
+    uint16_t len = key_len;
+    if (len > 0 && len < max_len) {
+        out_key[len++] = '/';
+    }
 
-        const bool skipField = skipFromField || skipTypeField;
+    const jsmntok_t token = json_token(&parser_tx_obj.json, key_token_index);
+    uint16_t size = token.end - token.start;
+    if (size > max_len - len) {
+        size = max_len - len;
+    }
 
-        CHECK_APP_CANARY()
+    MEMCPY(out_key + len, parser_tx_obj.tx + token.start, size);
+    out_key[len + size] = 0;
+}
 
-        // Early bail out
-        if (!skipField && parser_tx_obj.query._item_index_current == parser_tx_obj.query.item_index) {
-            *ret_value_token_index = root_token_index;
-            CHECK_APP_CANARY()
+void tx_traverse_start(tx_traversal_t *t, uint16_t root_token_index, key_id_e root_key_id,
+                       uint8_t max_level, uint8_t max_depth,
+                       char *out_key, uint16_t out_key_len) {
+    t->num_frames = 0;
+    t->root_token_index = root_token_index;
+    t->root_key_id = root_key_id;
+    t->key_id = key_unknown;
+    t->root_level = max_level;
+    t->root_depth = max_depth;
+    if (t->root_depth > MAX_TRAVERSAL_DEPTH) {
+        t->root_depth = MAX_TRAVERSAL_DEPTH;
+    }
+    t->root_pending = true;
+    t->out_key = out_key;
+    t->out_key_len = out_key_len;
+}
+
+parser_error_t tx_traverse_next(tx_traversal_t *t, uint16_t *leaf_token_index) {
+    if (parser_tx_obj.tx == NULL) {
+        return parser_no_data;
+    }
+
+    if (t->root_pending) {
+        t->root_pending = false;
+        if (traverse_enter(t, t->root_token_index, t->root_key_id, t->root_level, t->root_depth)) {
+            *leaf_token_index = t->root_token_index;
             return parser_ok;
         }
+    }
 
-        if (skipField) {
-            parser_tx_obj.query.item_index++;
+    while (t->num_frames > 0) {
+        tx_traverse_frame_t *frame = &t->frames[t->num_frames - 1];
+        // every frame uses one unit of depth
+        const uint8_t child_depth = t->root_depth - t->num_frames;
+
+        // children alternate key and value
+        if (frame->child + frame->is_object >= frame->end) {
+            // Done with this container, restore the key it was entered with
+            if (frame->is_object && t->out_key != NULL) {
+                t->out_key[frame->key_len] = 0;
+            }
+            t->num_frames--;
+            continue;
         }
 
-        parser_tx_obj.query._item_index_current++;
-        CHECK_APP_CANARY()
-        return parser_query_no_results;
+        uint16_t child = frame->child;
+        uint8_t child_level = frame->level;
+        if (frame->is_object) {
+            // When traversing objects both level and depth should be considered
+            frame->key = child;
+            frame->key_id = tx_key_child(frame->path_id, child);
+            if (t->out_key != NULL) {
+                traverse_set_key(t, frame->key_len, child);
+            }
+            child++;
+            child_level--;
+        }
+        frame->child = json_next_sibling(&parser_tx_obj.json, child);
+
+        if (traverse_enter(t, child, frame->key_id, child_level, child_depth)) {
+            *leaf_token_index = child;
+            return parser_ok;
+        }
     }
 
-    uint16_t el_count;
-    parser_error_t err;
+    return parser_query_no_results;
+}
 
-    CHECK_PARSER_ERR(object_get_element_count(&parser_tx_obj.json, root_token_index, &el_count))
+uint8_t tx_traverse_keys(const tx_traversal_t *t, uint16_t *first_key_token_index) {
+    uint8_t num_keys = 0;
+    for (uint8_t i = 0; i < t->num_frames; i++) {
+        const tx_traverse_frame_t *frame = &t->frames[i];
+        if (!frame->is_object) {
+            continue;
+        }
+        if (num_keys == 0) {
+            *first_key_token_index = frame->key;
+        }
+        num_keys++;
+    }
+    return num_keys;
+}
 
-    switch (token_type) {
-        case JSMN_OBJECT: {
-            const size_t key_len = strlen(parser_tx_obj.query.out_key);
-            for (uint16_t i = 0; i < el_count; ++i) {
-                uint16_t key_index;
-                uint16_t value_index;
+#if defined(TX_REFERENCE_SEARCH)
+static tx_traversal_t traversal;
 
-                CHECK_PARSER_ERR(object_get_nth_key(&parser_tx_obj.json, root_token_index, i, &key_index))
-                CHECK_PARSER_ERR(object_get_nth_value(&parser_tx_obj.json, root_token_index, i, &value_index))
+parser_error_t tx_traverse_find(uint16_t root_token_index, uint16_t *ret_value_token_index) {
+    CHECK_APP_CANARY()
 
-                // Skip writing keys if we are actually exploring to count
-                append_key_item(key_index);
-                CHECK_APP_CANARY()
+    if (parser_tx_obj.tx == NULL) {
+        return parser_no_data;
+    }
 
-                // When traversing objects both level and depth should be considered
-                parser_tx_obj.query.max_level--;
-                parser_tx_obj.query.max_depth--;
+    // the token before the value of a root item is its key
+    const key_id_e root_key_id = root_token_index > ROOT_TOKEN_INDEX ?
+                                 tx_key_child(key_root, root_token_index - 1) : key_unknown;
 
-                // Traverse the value, extracting subkeys
-                err = tx_traverse_find(value_index, ret_value_token_index);
-                CHECK_APP_CANARY()
-                parser_tx_obj.query.max_level++;
-                parser_tx_obj.query.max_depth++;
+    tx_traverse_start(&traversal, root_token_index, root_key_id,
+                      parser_tx_obj.query.max_level, parser_tx_obj.query.max_depth,
+                      parser_tx_obj.query.out_key, parser_tx_obj.query.out_key_len);
 
-                if (err == parser_ok) {
-                    return parser_ok;
-                }
+    uint16_t leaf_token_index;
+    while (tx_traverse_next(&traversal, &leaf_token_index) == parser_ok) {
+        const bool skipField = tx_is_grouped_field(traversal.key_id,
+                                                   parser_tx_obj.query._item_index_current);
 
-                *(parser_tx_obj.query.out_key + key_len) = 0;
-                CHECK_APP_CANARY()
-            }
-            break;
+        // Early bail out
+        if (!skipField && parser_tx_obj.query._item_index_current == parser_tx_obj.query.item_index) {
+            *ret_value_token_index = leaf_token_index;
+            parser_tx_obj.query.out_key_id = traversal.key_id;
+            return parser_ok;
         }
-        case JSMN_ARRAY: {
-            for (uint16_t i = 0; i < el_count; ++i) {
-                uint16_t element_index;
-                CHECK_PARSER_ERR(array_get_nth_element(&parser_tx_obj.json,
-                                                       root_token_index, i,
-                                                       &element_index))
-                CHECK_APP_CANARY()
-
-                // When iterating along an array,
-                // the level does not change but we need to count the recursion
-                parser_tx_obj.query.max_depth--;
-                err = tx_traverse_find(element_index, ret_value_token_index);
-                parser_tx_obj.query.max_depth++;
-
-                CHECK_APP_CANARY()
-
-                if (err == parser_ok) {
-                    return parser_ok;
-                }
-            }
-            break;
+
+        if (skipField) {
+            parser_tx_obj.query.item_index++;
         }
-        default:
-            break;
+
+        parser_tx_obj.query._item_index_current++;
     }
 
     return parser_query_no_results;
 }
-
-#ifdef __cplusplus
-#pragma clang diagnostic pop
 #endif
@@ -24,17 +24,29 @@
 #include <stdint.h>
 #include <common/parser_common.h>
 #include "zxmacros.h"
+#include "known_keys.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-#define MAX_RECURSION_DEPTH  6
+// Maximum nesting walked below a root item. Deeper values are shown as raw json
+#if !defined(MAX_TRAVERSAL_DEPTH)
+#if defined(TARGET_NANOS)
+#define MAX_TRAVERSAL_DEPTH  8
+#else
+#define MAX_TRAVERSAL_DEPTH  16
+#endif
+#endif
+
 #define MULTISEND_KEY_IDX    9
 
+// TX_REFERENCE_SEARCH builds the search that the display cursor replaced (tx_traverse_find, tx_display_find).
+// The host tests and benchmarks compare the cursor with it, the device build leaves it out
+#if defined(TX_REFERENCE_SEARCH)
 #define INIT_QUERY_CONTEXT(_KEY, _KEY_LEN, _VAL, _VAL_LEN, _PAGE_IDX, _MAX_LEVEL) \
     parser_tx_obj.query._item_index_current = 0; \
-    parser_tx_obj.query.max_depth = MAX_RECURSION_DEPTH; \
+    parser_tx_obj.query.max_depth = MAX_TRAVERSAL_DEPTH; \
     parser_tx_obj.query.max_level = _MAX_LEVEL; \
     \
     parser_tx_obj.query.item_index= 0; \
@@ -45,25 +57,80 @@ extern "C" {
     parser_tx_obj.query.out_key= _KEY; \
     parser_tx_obj.query.out_val= _VAL; \
     parser_tx_obj.query.out_key_len = (_KEY_LEN); \
+    parser_tx_obj.query.out_key_id = key_unknown; \
     parser_tx_obj.query.out_val_len = (_VAL_LEN);
+#endif
+
+// Known path of the key token below the known path parent (key_unknown if there is none)
+key_id_e tx_key_child(key_id_e parent, uint16_t key_token_index);
+
+// Container being walked by the traversal
+typedef struct {
+    // next child to visit (the key, for objects)
+    uint16_t child;
+    uint16_t end;
+    // current key (objects only)
+    uint16_t key;
+    // length of out_key when the object was entered
+    uint16_t key_len;
+    // levels left for the container
+    uint8_t level;
+    uint8_t is_object;
+    // known path of the container, and of its current key (the same for arrays)
+    uint8_t path_id;
+    uint8_t key_id;
+} tx_traverse_frame_t;
+
+// Position of a walk over the leaves below a root item.
+// The stack is bounded by the depth limit, so its size does not depend on the transaction
+typedef struct {
+    tx_traverse_frame_t frames[MAX_TRAVERSAL_DEPTH];
+    uint8_t num_frames;
+    // depth left for the root token
+    uint8_t root_depth;
+    uint8_t root_level;
+    uint16_t root_token_index;
+    uint8_t root_key_id;
+    bool root_pending;
+    // known path of the current leaf
+    uint8_t key_id;
+    // key of the current leaf (optional)
+    char *out_key;
+    uint16_t out_key_len;
+} tx_traversal_t;
 
+// Starts walking the leaves under root_token_index, limited by max_level and max_depth.
+// root_key_id is the known path of root_token_index.
+// out_key holds the key of root_token_index, and it is extended with the keys of the path to each leaf.
+// It can be NULL when only the known path of the leaves is needed
+void tx_traverse_start(tx_traversal_t *t, uint16_t root_token_index, key_id_e root_key_id,
+                       uint8_t max_level, uint8_t max_depth,
+                       char *out_key, uint16_t out_key_len);
+
+// Moves to the next leaf, in document order.
+// Returns parser_query_no_results after the last leaf, with out_key restored
+parser_error_t tx_traverse_next(tx_traversal_t *t, uint16_t *leaf_token_index);
+
+// Number of object keys in the path of the current leaf. The first of them is returned in first_key_token_index
+uint8_t tx_traverse_keys(const tx_traversal_t *t, uint16_t *first_key_token_index);
+
+#if defined(TX_REFERENCE_SEARCH)
+// Finds the query.item_index-th visible leaf under root_token_index, the value of a root item.
+// The known path of the leaf is returned in query.out_key_id
 parser_error_t tx_traverse_find(uint16_t root_token_index, uint16_t *ret_value_token_index);
+#endif
 
-// Traverses transaction data and fills tx_context
-parser_error_t tx_traverse(int16_t root_token_index, uint8_t *numChunks);
+// Appends the key token to the current query key (out_key), with a '/' separator
+void tx_append_key_item(uint16_t token_index);
 
 // Retrieves the value for the corresponding token index. If the value goes beyond val_len, the chunk_idx will be used
 parser_error_t tx_getToken(uint16_t token_index,
                            char *out_val, uint16_t out_val_len,
                            uint8_t pageIdx, uint8_t *pageCount);
 
-__Z_INLINE bool is_msg_type_field(char *field_name) {
-    return strcmp(field_name, "msgs/type") == 0;
-}
-
-__Z_INLINE bool is_msg_from_field(char *field_name) {
-    return strcmp(field_name, "msgs/value/delegator_address") == 0;
-}
+// Indicates if the field is hidden by msg type/from grouping
+// item_index is the position of the field in the msgs root item, including hidden fields
+bool tx_is_grouped_field(key_id_e key_id, uint16_t item_index);
 
 #ifdef __cplusplus
 }
@@ -18,6 +18,9 @@
 #include <common/parser_common.h>
 #include <zxmacros.h>
 #include "json/json_parser.h"
+#include "tx_validate.h"
+#include "tx_display.h"
+#include "coin.h"
 
 const char whitespaces[] = {
         0x20,// space ' '
@@ -28,145 +31,188 @@ const char whitespaces[] = {
         0x0b // vertical_tab, '\v'
 };
 
-int8_t is_space(char c) {
+__Z_INLINE bool is_space(char c) {
     for (uint32_t i = 0; i < sizeof(whitespaces); i++) {
         if (whitespaces[i] == c) {
-            return 1;
+            return true;
         }
     }
-    return 0;
+    return false;
 }
 
-int8_t contains_whitespace(parsed_json_t *json) {
-    int start = 0;
-    const int last_element_index = json->tokens[0].end;
-
-    // Starting at token 1 because token 0 contains full tx
-    for (uint32_t i = 1; i < json->numberOfTokens; i++) {
-        if (json->tokens[i].type != JSMN_UNDEFINED) {
-            const int end = json->tokens[i].start;
-            for (int j = start; j < end; j++) {
-                if (is_space(json->buffer[j]) == 1) {
-                    return 1;
-                }
-            }
-            start = json->tokens[i].end + 1;
-        } else {
-            return 0;
-        }
-    }
-    while (start < last_element_index && json->buffer[start] != '\0') {
-        if (is_space(json->buffer[start])) {
-            return 1;
+__Z_INLINE bool range_contains_whitespace(const parsed_json_t *json, uint16_t from, uint16_t to) {
+    for (uint16_t j = from; j < to; j++) {
+        if (is_space(json->buffer[j])) {
+            return true;
         }
-        start++;
     }
-    return 0;
+    return false;
 }
 
-int8_t is_sorted(uint16_t first_index,
-                 uint16_t second_index,
-                 parsed_json_t *json) {
-    char first[256];
-    char second[256];
-    MEMZERO(first, sizeof first);
-    MEMZERO(second, sizeof second);
-
-    size_t size = json->tokens[first_index].end - json->tokens[first_index].start;
-    if (size >= sizeof(first)) {
-        return 0;
+// Compares two keys in place, with the same ordering as strcmp
+__Z_INLINE int32_t compare_keys(const parsed_json_t *json, uint16_t first_index, uint16_t second_index) {
+    const jsmntok_t first = json_token(json, first_index);
+    const jsmntok_t second = json_token(json, second_index);
+    const uint16_t first_len = first.end - first.start;
+    const uint16_t second_len = second.end - second.start;
+    const uint16_t len = first_len < second_len ? first_len : second_len;
+
+    const int cmp = MEMCMP(json->buffer + first.start, json->buffer + second.start, len);
+    if (cmp != 0) {
+        return cmp;
     }
+    return (int32_t) first_len - (int32_t) second_len;
+}
+
+// Root fields in the order of their keys
+static const root_item_e root_items_sorted[NUM_REQUIRED_ROOT_PAGES] = {
+        root_item_account_number,
+        root_item_chain_id,
+        root_item_data,
+        root_item_memo,
+        root_item_msgs,
+        root_item_sequence,
+        root_item_source,
+};
 
-    strncpy(first, json->buffer + json->tokens[first_index].start, size);
-    first[size] = '\0';
+// Compares a key with a name, with the same ordering as strcmp
+__Z_INLINE int32_t compare_key_name(const parsed_json_t *json, uint16_t key_index, const char *name) {
+    const jsmntok_t key = json_token(json, key_index);
+    const uint16_t key_len = key.end - key.start;
+    const uint16_t name_len = (uint16_t) strlen(name);
+    const uint16_t len = key_len < name_len ? key_len : name_len;
 
-    size = json->tokens[second_index].end - json->tokens[second_index].start;
-    if (size >= sizeof(second)) return 0;
+    const int cmp = MEMCMP(json->buffer + key.start, name, len);
+    if (cmp != 0) {
+        return cmp;
+    }
+    return (int32_t) key_len - (int32_t) name_len;
+}
 
-    strncpy(second, json->buffer + json->tokens[second_index].start, size);
-    second[size] = '\0';
+__Z_INLINE bool is_default_chain_id(const parsed_json_t *json, uint16_t value_index) {
+    const jsmntok_t value = json_token(json, value_index);
+    const uint16_t len = (uint16_t) strlen(COIN_DEFAULT_CHAINID);
+    return value.type == JSMN_STRING &&
+           value.end - value.start == len &&
+           MEMCMP(json->buffer + value.start, COIN_DEFAULT_CHAINID, len) == 0;
+}
 
-    if (strcmp(first, second) <= 0) {
-        return 1;
+// Called with the root keys in increasing order, as they are checked. Both lists are sorted, so they are
+// merged: next_field is the first root field that sorts after the previous key
+__Z_INLINE void match_root_field(const parsed_json_t *json, uint16_t key_index,
+                                 tx_root_slots_t *root_slots, uint8_t *next_field) {
+    int32_t cmp = 1;
+    while (*next_field < NUM_REQUIRED_ROOT_PAGES &&
+           (cmp = compare_key_name(json, key_index, get_required_root_item(root_items_sorted[*next_field]))) > 0) {
+        // the field sorts before this key, so it is missing
+        (*next_field)++;
+    }
+    if (*next_field >= NUM_REQUIRED_ROOT_PAGES || cmp != 0) {
+        return;
     }
 
-    return 0;
+    const root_item_e root_item = root_items_sorted[*next_field];
+    (*next_field)++;
+    root_slots->value_token[root_item] = key_index + 1;
+    if (root_item == root_item_chain_id) {
+        root_slots->is_default_chain = is_default_chain_id(json, key_index + 1);
+    }
 }
 
-int8_t dictionaries_sorted(parsed_json_t *json) {
-    for (uint32_t i = 0; i < json->numberOfTokens; i++) {
-        if (json->tokens[i].type == JSMN_OBJECT) {
+// Keys must be strictly increasing. The root fields are found on the way when root_slots is not NULL
+__Z_INLINE parser_error_t check_object_keys(const parsed_json_t *json, uint16_t object_index,
+                                            tx_root_slots_t *root_slots) {
+    const uint16_t end = json_next_sibling(json, object_index);
+    uint16_t prev_key_index = json_first_child(json, object_index);
+    if (prev_key_index + 1 >= end) {
+        return parser_ok;
+    }
 
-            uint16_t count;
+    uint8_t next_field = 0;
+    if (root_slots != NULL) {
+        match_root_field(json, prev_key_index, root_slots, &next_field);
+    }
 
-            if (object_get_element_count(json, i, &count) != parser_ok) {
-                return 0;
-            }
+    // children alternate key and value
+    for (uint16_t key_index = json_next_sibling(json, prev_key_index + 1);
+         key_index + 1 < end;
+         key_index = json_next_sibling(json, key_index + 1)) {
+        const int32_t cmp = compare_keys(json, prev_key_index, key_index);
+        if (cmp == 0) {
+            return parser_duplicated_field;
+        }
+        if (cmp > 0) {
+            return parser_json_is_not_sorted;
+        }
+        if (root_slots != NULL) {
+            match_root_field(json, key_index, root_slots, &next_field);
+        }
+        prev_key_index = key_index;
+    }
+    return parser_ok;
+}
+
+// Single pass over the tokens in document order.
+// Bytes between tokens (brackets, separators and quotes) must not be whitespace, and the keys of every
+// object are checked when the object is reached. Whitespace is reported before key order errors.
+// The root fields are filled in root_slots while the root keys are checked
+__Z_INLINE parser_error_t check_canonical(const parsed_json_t *json, tx_root_slots_t *root_slots) {
+    if (json->numberOfTokens == 0) {
+        return parser_ok;
+    }
 
-            if (count > 1) {
-                uint16_t prev_token_index;
-                if (object_get_nth_key(json, i, 0, &prev_token_index) != parser_ok) {
-                    return 0;
-                }
+    parser_error_t order_err = parser_ok;
+    uint16_t pos = 0;
 
-                for (int j = 1; j < count; j++) {
-                    uint16_t next_token_index;
+    for (uint16_t i = 0; i < json->numberOfTokens; i++) {
+        const jsmntok_t token = json_token(json, i);
 
-                    if (object_get_nth_key(json, i, j, &next_token_index) != parser_ok) {
-                        return 0;
-                    }
+        if (range_contains_whitespace(json, pos, token.start)) {
+            return parser_json_contains_whitespace;
+        }
 
-                    if (!is_sorted(prev_token_index, next_token_index, json)) {
-                        return 0;
-                    }
-                    prev_token_index = next_token_index;
-                }
+        if (token.type == JSMN_OBJECT || token.type == JSMN_ARRAY) {
+            // continue with the children
+            pos = token.start + 1;
+            if (token.type == JSMN_OBJECT && order_err == parser_ok) {
+                order_err = check_object_keys(json, i, i == ROOT_TOKEN_INDEX ? root_slots : NULL);
             }
+        } else {
+            pos = token.end;
         }
     }
-    return 1;
-}
 
-parser_error_t tx_validate(parsed_json_t *json) {
-    if (contains_whitespace(json) == 1) {
+    if (range_contains_whitespace(json, pos, json_token(json, ROOT_TOKEN_INDEX).end)) {
         return parser_json_contains_whitespace;
     }
 
-    if (dictionaries_sorted(json) != 1) {
-        return parser_json_is_not_sorted;
-    }
+    return order_err;
+}
 
-    uint16_t token_index;
-    parser_error_t err;
+parser_error_t tx_validate(parsed_json_t *json, tx_root_slots_t *root_slots) {
+    MEMZERO(root_slots, sizeof(tx_root_slots_t));
+    CHECK_PARSER_ERR(check_canonical(json, root_slots))
 
-    err = object_get_value(json, 0, "chain_id", &token_index);
-    if (err != parser_ok)
+    const uint16_t *value_token = root_slots->value_token;
+
+    if (value_token[root_item_chain_id] == 0)
         return parser_json_missing_chain_id;
 
-    err = object_get_value(json, 0, "sequence", &token_index);
-    if (err != parser_ok)
+    if (value_token[root_item_sequence] == 0)
         return parser_json_missing_sequence;
 
-    err = object_get_value(json, 0, "msgs", &token_index);
-    if (err != parser_ok)
+    if (value_token[root_item_msgs] == 0)
         return parser_json_missing_msgs;
 
-    err = object_get_value(json, 0, "account_number", &token_index);
-    if (err != parser_ok)
+    if (value_token[root_item_account_number] == 0)
         return parser_json_missing_account_number;
 
-    err = object_get_value(json, 0, "memo", &token_index);
-    if (err != parser_ok)
+    if (value_token[root_item_memo] == 0)
         return parser_json_missing_memo;
-    
-    err = object_get_value(json, 0, "data", &token_index);
-    if (err != parser_ok)
-        return parser_json_missing_data;
 
-    err = object_get_value(json, 0, "source", &token_index);
-    if (err != parser_ok)
+    if (value_token[root_item_data] == 0 || value_token[root_item_source] == 0)
         return parser_json_missing_data;
 
-
+    root_slots->valid = true;
     return parser_ok;
 }
@@ -19,16 +19,18 @@
 #include "json/json_parser.h"
 #include <stdint.h>
 #include <common/parser_common.h>
+#include "parser_txdef.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 /// Validate json transaction
+/// The json must be canonical (no whitespace, object keys sorted and unique) and contain the required root fields
 /// \param parsed_transacton
-/// \param transaction
+/// \param root_slots root fields, found while the root keys are checked (valid only if the tx is valid)
 /// \return
-parser_error_t tx_validate(parsed_json_t *json);
+parser_error_t tx_validate(parsed_json_t *json, tx_root_slots_t *root_slots);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,241 @@
+/*******************************************************************************
+*   (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include "json/json_parser.h"
+#include "zxmacros.h"
+
+namespace {
+    parsed_json_t json;
+    jsmntok_t tokens[MAX_NUMBER_OF_TOKENS];
+
+    std::string tokenValue(const std::string &s, uint16_t token_index) {
+        return s.substr(json.tokens[token_index].start,
+                        json.tokens[token_index].end - json.tokens[token_index].start);
+    }
+}
+
+TEST(JsonParser, SiblingLinks) {
+    const std::string s = R"({"a":[1,{"b":2},[3,4]],"c":"x"})";
+    ASSERT_EQ(json_parse(&json, tokens, MAX_NUMBER_OF_TOKENS, s.c_str(), s.size()), parser_ok);
+
+    // 0:{ 1:a 2:[ 3:1 4:{ 5:b 6:2 7:[ 8:3 9:4 10:c 11:x
+    ASSERT_EQ(json.numberOfTokens, 12u);
+    EXPECT_EQ(json_next_sibling(&json, 0), 12);
+    EXPECT_EQ(json_next_sibling(&json, 1), 2);
+    EXPECT_EQ(json_next_sibling(&json, 2), 10);
+    EXPECT_EQ(json_next_sibling(&json, 3), 4);
+    EXPECT_EQ(json_next_sibling(&json, 4), 7);
+    EXPECT_EQ(json_next_sibling(&json, 7), 10);
+    EXPECT_EQ(json_next_sibling(&json, 9), 10);
+    EXPECT_EQ(json_next_sibling(&json, 11), 12);
+}
+
+TEST(JsonParser, ArrayElements) {
+    const std::string s = R"([1,{"b":2},[3,4],"x"])";
+    ASSERT_EQ(json_parse(&json, tokens, MAX_NUMBER_OF_TOKENS, s.c_str(), s.size()), parser_ok);
+
+    uint16_t count;
+    ASSERT_EQ(array_get_element_count(&json, 0, &count), parser_ok);
+    EXPECT_EQ(count, 4);
+
+    uint16_t token_index;
+    ASSERT_EQ(array_get_nth_element(&json, 0, 0, &token_index), parser_ok);
+    EXPECT_EQ(tokenValue(s, token_index), "1");
+    ASSERT_EQ(array_get_nth_element(&json, 0, 2, &token_index), parser_ok);
+    EXPECT_EQ(tokenValue(s, token_index), "[3,4]");
+    ASSERT_EQ(array_get_nth_element(&json, 0, 3, &token_index), parser_ok);
+    EXPECT_EQ(tokenValue(s, token_index), "x");
+    EXPECT_EQ(array_get_nth_element(&json, 0, 4, &token_index), parser_no_data);
+
+    ASSERT_EQ(array_get_element_count(&json, token_index - 3, &count), parser_ok);
+    EXPECT_EQ(count, 2);
+}
+
+TEST(JsonParser, EmptyContainers) {
+    const std::string s = R"({"a":[],"b":{}})";
+    ASSERT_EQ(json_parse(&json, tokens, MAX_NUMBER_OF_TOKENS, s.c_str(), s.size()), parser_ok);
+
+    uint16_t count;
+    uint16_t token_index;
+    ASSERT_EQ(object_get_value(&json, 0, "a", &token_index), parser_ok);
+    ASSERT_EQ(array_get_element_count(&json, token_index, &count), parser_ok);
+    EXPECT_EQ(count, 0);
+    EXPECT_EQ(array_get_nth_element(&json, token_index, 0, &token_index), parser_no_data);
+
+    ASSERT_EQ(object_get_value(&json, 0, "b", &token_index), parser_ok);
+    ASSERT_EQ(object_get_element_count(&json, token_index, &count), parser_ok);
+    EXPECT_EQ(count, 0);
+    EXPECT_EQ(object_get_nth_key(&json, token_index, 0, &token_index), parser_no_data);
+}
+
+// Strings are scanned a word at a time, the escapes and the end must be found at any alignment
+TEST(JsonParser, StringScan) {
+    alignas(16) char buffer[128];
+    const std::vector<std::string> values = {
+            "", "a", "abcdefghijklmnopqrstuvwxyz0123456789",
+            R"(abcdefg\"hij)", R"(\\abcdefghijklmnop\n)", R"(abcdefghijklmnopq\u00e9rstuvwxyz)",
+            "\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9", "abcdefghijk\tlmnopqrstu",
+    };
+
+    for (size_t offset = 0; offset < 16; offset++) {
+        for (const auto &value : values) {
+            const std::string s = R"({"k":")" + value + R"("})";
+            MEMCPY(buffer + offset, s.c_str(), s.size());
+            ASSERT_EQ(json_parse(&json, tokens, MAX_NUMBER_OF_TOKENS, buffer + offset, s.size()), parser_ok)
+                                        << offset << " " << value;
+            ASSERT_EQ(json.numberOfTokens, 3u);
+            EXPECT_EQ(std::string(buffer + offset + tokens[2].start, tokens[2].end - tokens[2].start), value)
+                                << offset << " " << value;
+        }
+
+        // cut string, and '\0' before the end
+        const std::string cut = R"({"k":"abcdefghijklmnopqrstuvwxyz)";
+        MEMCPY(buffer + offset, cut.c_str(), cut.size());
+        EXPECT_EQ(json_parse(&json, tokens, MAX_NUMBER_OF_TOKENS, buffer + offset, cut.size()),
+                  parser_json_incomplete_json) << offset;
+        buffer[offset + 20] = '\0';
+        EXPECT_EQ(json_parse(&json, tokens, MAX_NUMBER_OF_TOKENS, buffer + offset, cut.size()),
+                  parser_json_incomplete_json) << offset;
+
+        const std::string bad = R"({"k":"abcdefghijklmnopq\x"})";
+        MEMCPY(buffer + offset, bad.c_str(), bad.size());
+        EXPECT_EQ(json_parse(&json, tokens, MAX_NUMBER_OF_TOKENS, buffer + offset, bad.size()),
+                  parser_unexpected_characters) << offset;
+    }
+}
+
+// Outside strings, control characters and non-ASCII bytes are rejected, other primitives are not checked
+TEST(JsonParser, CharacterClasses) {
+    const auto parse = [](const std::string &s) {
+        return json_parse(&json, tokens, MAX_NUMBER_OF_TOKENS, s.c_str(), s.size());
+    };
+
+    EXPECT_EQ(parse("{\"a\":1\x01}"), parser_unexpected_characters);
+    EXPECT_EQ(parse("{\"a\":\x80}"), parser_unexpected_characters);
+    EXPECT_EQ(parse("{\"a\":1\x7f}"), parser_unexpected_characters);
+    EXPECT_EQ(parse("{\"a\":\"\x01\x80\"}"), parser_ok);
+    EXPECT_EQ(parse("{\"a\":-1.5e3,\"b\":tru,\"c\":x}"), parser_ok);
+    EXPECT_EQ(json.numberOfTokens, 7u);
+    EXPECT_EQ(tokenValue("{\"a\":-1.5e3,\"b\":tru,\"c\":x}", 2), "-1.5e3");
+    EXPECT_EQ(parse("{\"a\" :\t[1 ,2\r\n]}"), parser_ok);
+    EXPECT_EQ(json.numberOfTokens, 5u);
+}
+
+TEST(JsonParser, ObjectElements) {
+    const std::string s = R"({"account_number":"1","chain_id":"x","msgs":[{"a":1}],"sequence":{"n":2}})";
+    ASSERT_EQ(json_parse(&json, tokens, MAX_NUMBER_OF_TOKENS, s.c_str(), s.size()), parser_ok);
+
+    uint16_t count;
+    ASSERT_EQ(object_get_element_count(&json, 0, &count), parser_ok);
+    EXPECT_EQ(count, 4);
+
+    uint16_t token_index;
+    ASSERT_EQ(object_get_nth_key(&json, 0, 3, &token_index), parser_ok);
+    EXPECT_EQ(tokenValue(s, token_index), "sequence");
+    ASSERT_EQ(object_get_nth_value(&json, 0, 2, &token_index), parser_ok);
+    EXPECT_EQ(tokenValue(s, token_index), R"([{"a":1}])");
+    EXPECT_EQ(object_get_nth_key(&json, 0, 4, &token_index), parser_no_data);
+
+    ASSERT_EQ(object_get_value(&json, 0, "sequence", &token_index), parser_ok);
+    EXPECT_EQ(tokenValue(s, token_index), R"({"n":2})");
+    ASSERT_EQ(object_get_value(&json, 0, "chain_id", &token_index), parser_ok);
+    EXPECT_EQ(tokenValue(s, token_index), "x");
+    EXPECT_EQ(object_get_value(&json, 0, "n", &token_index), parser_no_data);
+    EXPECT_EQ(object_get_value(&json, 0, "chain", &token_index), parser_no_data);
+}
+
+#if defined(JSMN_PACKED)
+TEST(JsonParser, PackedTokens) {
+    EXPECT_EQ(sizeof(jsmntok_t), 6u);
+
+    const std::string s = R"({"k":[true,"v"]})";
+    ASSERT_EQ(json_parse(&json, tokens, MAX_NUMBER_OF_TOKENS, s.c_str(), s.size()), parser_ok);
+
+    // 0:{ 1:k 2:[ 3:true 4:v
+    ASSERT_EQ(json.numberOfTokens, 5u);
+    EXPECT_EQ(json.tokens[0].type, JSMN_OBJECT);
+    EXPECT_EQ(json.tokens[2].type, JSMN_ARRAY);
+    EXPECT_EQ(json.tokens[3].type, JSMN_PRIMITIVE);
+    EXPECT_EQ(json.tokens[4].type, JSMN_STRING);
+    EXPECT_EQ(tokenValue(s, 4), "v");
+    EXPECT_EQ(json_next_sibling(&json, 2), 5);
+}
+
+namespace {
+    void expectSameToken(const jsmntok_t &actual, const jsmntok_t &expected, uint16_t token_index) {
+        EXPECT_EQ(actual.start, expected.start) << token_index;
+        EXPECT_EQ(actual.end, expected.end) << token_index;
+        EXPECT_EQ(actual.type, expected.type) << token_index;
+        EXPECT_EQ(actual.next, expected.next) << token_index;
+    }
+}
+
+// The skeleton and the window give the same tokens as the full tokenization, in any order
+TEST(JsonParser, WindowedTokens) {
+    const std::string s = R"({"chain_id":"x","msgs":[{"a":[1,2],"b":{"c":"d"}},7,"s",[],{"e":[{"f":1}]}],)"
+                          R"("sequence":{"n":[2,3]}})";
+    ASSERT_EQ(json_parse(&json, tokens, MAX_NUMBER_OF_TOKENS, s.c_str(), s.size()), parser_ok);
+    const std::vector<jsmntok_t> expected(tokens, tokens + json.numberOfTokens);
+
+    // skeleton: root, 2 keys and values up to msgs, 5 elements, 6 tokens after msgs; largest element: 9 tokens
+    const uint16_t max_tokens = 1 + 4 + 5 + 6 + 9;
+    parsed_json_t windowed;
+    json_window_t window;
+    jsmntok_t storage[max_tokens];
+    ASSERT_EQ(json_parse_windowed(&windowed, &window, storage, max_tokens - 1, s.c_str(), s.size()),
+              parser_json_too_many_tokens);
+    ASSERT_EQ(json_parse_windowed(&windowed, &window, storage, max_tokens, s.c_str(), s.size()), parser_ok);
+    ASSERT_EQ(windowed.numberOfTokens, json.numberOfTokens);
+    EXPECT_EQ(json_tokens_in_use(&windowed), max_tokens);
+
+    const auto n = (uint16_t) expected.size();
+    for (uint16_t i = 0; i < n; i++) {
+        expectSameToken(json_token(&windowed, i), expected[i], i);
+    }
+    for (uint16_t i = n; i > 0; i--) {
+        expectSameToken(json_token(&windowed, i - 1), expected[i - 1], i - 1);
+    }
+    for (uint16_t i = 0; i < n; i++) {
+        const auto token_index = (uint16_t) (i * 7 % n);
+        expectSameToken(json_token(&windowed, token_index), expected[token_index], token_index);
+    }
+
+    uint16_t token_index;
+    ASSERT_EQ(object_get_value(&windowed, 0, "sequence", &token_index), parser_ok);
+    EXPECT_EQ(token_index, n - 5);
+    EXPECT_EQ(json_token(&windowed, n).start, JSMN_POS_UNSET);
+}
+
+TEST(JsonParser, WindowedErrors) {
+    parsed_json_t windowed;
+    json_window_t window;
+    const auto parse = [&](const std::string &s) {
+        return json_parse_windowed(&windowed, &window, tokens, MAX_NUMBER_OF_TOKENS, s.c_str(), s.size());
+    };
+
+    EXPECT_EQ(parse(R"({"a":1})"), parser_json_too_many_tokens);
+    EXPECT_EQ(parse(R"({"msgs":{"a":1}})"), parser_json_too_many_tokens);
+    EXPECT_EQ(parse(R"({"msgs":[{"a":1},{"b":2})"), parser_json_incomplete_json);
+    EXPECT_EQ(parse(R"({"msgs":[{"a":1},{"b":2)"), parser_json_incomplete_json);
+    EXPECT_EQ(parse(R"({"msgs":[{"a":1}{"b":2}]})"), parser_unexpected_characters);
+    EXPECT_EQ(parse(R"({"msgs":[{"a":1],"b":2}]})"), parser_unexpected_characters);
+    EXPECT_EQ(parse(R"({"msgs":[{"a":1}],"b":2)"), parser_json_incomplete_json);
+    EXPECT_EQ(parse(R"({"b":[2],"msgs":[]})"), parser_ok);
+    EXPECT_EQ(windowed.numberOfTokens, 6u);
+}
+#endif
@@ -0,0 +1,46 @@
+/*******************************************************************************
+*   (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include <gtest/gtest.h>
+#include "utils/multisend.h"
+#include "utils/testcases.h"
+
+class MultisendTests : public ::testing::TestWithParam<uint16_t> {
+};
+
+INSTANTIATE_TEST_SUITE_P(
+        Generated,
+        MultisendTests,
+        ::testing::Values(1, 2, 3, 10, 25, 60, 150, 200)
+);
+
+TEST_P(MultisendTests, CanonicalAndComplete) {
+    const uint16_t numOutputs = GetParam();
+    const std::string tx = utils::multisendTx(numOutputs);
+
+    parser_context_t ctx;
+    ASSERT_EQ(utils::parseTx(&ctx, tx, false), parser_ok);
+
+    const auto ui = utils::dumpUI(&ctx, 40, 40);
+    ASSERT_FALSE(ui.empty());
+
+    uint16_t numItems = 0;
+    ASSERT_EQ(parser_getNumItems(&ctx, &numItems), parser_ok);
+    EXPECT_EQ(numItems, utils::multisendNumItems(numOutputs));
+
+    // Last output is shown last
+    EXPECT_NE(ui.back().find("Send output coins"), std::string::npos) << ui.back();
+    EXPECT_NE(ui.back().find("1.00000000 BNB"), std::string::npos) << ui.back();
+}
@@ -0,0 +1,30 @@
+/*******************************************************************************
+*   (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include "app_mode.h"
+
+static bool expert_mode = false;
+
+void app_mode_reset() {
+    expert_mode = false;
+}
+
+bool app_mode_expert() {
+    return expert_mode;
+}
+
+void app_mode_set_expert(bool val) {
+    expert_mode = val;
+}
@@ -0,0 +1,33 @@
+/*******************************************************************************
+*   (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include "zxmacros.h"
+
+nvm_stats_t nvm_stats;
+
+void nvm_write(void *dst_adr, void *src_adr, unsigned int src_len) {
+    if (src_len == 0) {
+        return;
+    }
+
+    const uintptr_t first_page = (uintptr_t) dst_adr / NVM_PAGE_SIZE;
+    const uintptr_t last_page = ((uintptr_t) dst_adr + src_len - 1) / NVM_PAGE_SIZE;
+
+    nvm_stats.writes++;
+    nvm_stats.bytes += src_len;
+    nvm_stats.pages += (uint32_t) (last_page - first_page + 1);
+
+    memcpy(dst_adr, src_adr, src_len);
+}
@@ -0,0 +1,41 @@
+/*******************************************************************************
+*   (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#pragma once
+
+// Host replacement for ledger-zxlib/include/zxerror.h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CHECK_ZXERR(CALL) { \
+    zxerr_t __zxerror = CALL;  \
+    if (__zxerror != zxerr_ok) return __zxerror;}
+
+typedef enum {
+    zxerr_unknown = 0b00000000,
+    zxerr_ok = 0b00000011,
+    zxerr_no_data = 0b00000101,
+    zxerr_buffer_too_small = 0b00000110,
+    zxerr_out_of_bounds = 0b00001001,
+    zxerr_encoding_failed = 0b00001010,
+    zxerr_invalid_crypto_settings = 0b00001100,
+    zxerr_ledger_api_error = 0b00001111,
+} zxerr_t;
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,148 @@
+/*******************************************************************************
+*   (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#pragma once
+
+// Host replacement for ledger-zxlib/include/zxformat.h
+// Behaviour mirrors the zxlib helpers used by the parser.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "zxmacros.h"
+
+__Z_INLINE uint8_t fpstr_to_str(char *out, uint16_t outLen, const char *number, uint8_t decimals) {
+    MEMZERO(out, outLen);
+    size_t digits = strlen(number);
+
+    // Empty input is zero
+    if (digits == 0) {
+        if (outLen < 2) {
+            return 1;
+        }
+        out[0] = '0';
+        return 0;
+    }
+
+    if (decimals == 0) {
+        if (digits + 1 > outLen) {
+            return 1;
+        }
+        MEMCPY(out, number, digits);
+        return 0;
+    }
+
+    // 0.[zeros][digits] + zero termination
+    if (digits <= decimals) {
+        if (outLen < decimals + 3) {
+            return 1;
+        }
+        *out++ = '0';
+        *out++ = '.';
+        for (size_t i = 0; i < decimals - digits; i++) {
+            *out++ = '0';
+        }
+        MEMCPY(out, number, digits);
+        return 0;
+    }
+
+    // [integer].[decimals] + zero termination
+    if (outLen < digits + 2) {
+        return 1;
+    }
+    const size_t shift = digits - decimals;
+    MEMCPY(out, number, shift);
+    out[shift] = '.';
+    MEMCPY(out + shift + 1, number + shift, decimals);
+    return 0;
+}
+
+__Z_INLINE void number_inplace_trimming(char *s, uint8_t non_trimmed) {
+    const size_t len = strlen(s);
+    if (len == 0 || len == 1 || len > 1024) {
+        return;
+    }
+
+    int16_t dec_point = -1;
+    for (int16_t i = 0; i < (int16_t) len && dec_point < 0; i++) {
+        if (s[i] == '.') {
+            dec_point = i;
+        }
+    }
+    if (dec_point < 0) {
+        return;
+    }
+
+    const size_t limit = (size_t) dec_point + non_trimmed;
+    for (size_t i = (len - 1); i > limit && s[i] == '0'; i--) {
+        s[i] = 0;
+    }
+}
+
+__Z_INLINE void z_str3join(char *s, size_t s_len, const char *prefix, const char *suffix) {
+    const size_t messageSize = strlen(s);
+    const size_t prefixSize = strlen(prefix);
+    const size_t suffixSize = strlen(suffix);
+
+    if (messageSize + prefixSize + suffixSize + 1 > s_len) {
+        return;
+    }
+
+    // shift message to make space for the prefix
+    MEMMOVE(s + prefixSize, s, messageSize + 1);
+    MEMCPY(s, prefix, prefixSize);
+    MEMCPY(s + prefixSize + messageSize, suffix, suffixSize + 1);
+}
+
+__Z_INLINE void pageStringExt(char *outValue, uint16_t outValueLen,
+                              const char *inValue, uint16_t inValueLen,
+                              uint8_t pageIdx, uint8_t *pageCount) {
+    MEMZERO(outValue, outValueLen);
+    *pageCount = 0;
+
+    outValueLen--;  // leave space for NULL termination
+    if (outValueLen == 0) {
+        return;
+    }
+    if (inValueLen == 0) {
+        return;
+    }
+
+    *pageCount = (uint8_t) (inValueLen / outValueLen);
+    const uint16_t lastChunkLen = (inValueLen % outValueLen);
+
+    if (lastChunkLen > 0) {
+        (*pageCount)++;
+    }
+
+    if (pageIdx < *pageCount) {
+        if (lastChunkLen > 0 && pageIdx == *pageCount - 1) {
+            MEMCPY(outValue, inValue + (pageIdx * outValueLen), lastChunkLen);
+        } else {
+            MEMCPY(outValue, inValue + (pageIdx * outValueLen), outValueLen);
+        }
+    }
+}
+
+__Z_INLINE void pageString(char *outValue, uint16_t outValueLen,
+                           const char *inValue,
+                           uint8_t pageIdx, uint8_t *pageCount) {
+    pageStringExt(outValue, outValueLen, inValue, (uint16_t) strlen(inValue), pageIdx, pageCount);
+}
+
+#ifdef __cplusplus
+}
+#endif
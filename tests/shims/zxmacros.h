@@ -0,0 +1,77 @@
+/*******************************************************************************
+*   (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#pragma once
+
+// Host replacement for ledger-zxlib/include/zxmacros.h
+// Only the subset used by the parser sources is provided.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdio.h>
+
+#define __Z_INLINE inline __attribute__((always_inline)) static
+
+#define NV_CONST
+#define NV_VOLATILE
+#define PIC(x) (x)
+
+#define MEMMOVE memmove
+#define MEMSET memset
+#define MEMCPY memcpy
+#define MEMCMP memcmp
+#define MEMCPY_NV(DST, SRC, LEN) nvm_write((void *) (DST), (void *) (SRC), (LEN))
+#define MEMZERO(buffer, bufferSize) memset((buffer), 0, (bufferSize))
+
+// Flash writes are counted so that benchmarks can report them (see nvm.c)
+typedef struct {
+    uint32_t writes;
+    uint32_t bytes;
+    // NVM pages touched, a page is erased and programmed for every write to it
+    uint32_t pages;
+} nvm_stats_t;
+
+#define NVM_PAGE_SIZE 64
+
+extern nvm_stats_t nvm_stats;
+
+void nvm_write(void *dst_adr, void *src_adr, unsigned int src_len);
+
+#define CHECK_APP_CANARY() {}
+
+#define array_length(array) (sizeof (array) / sizeof (array)[0])
+
+__Z_INLINE void zemu_log(__attribute__((unused)) const char *buf) {}
+
+__Z_INLINE void zemu_log_stack(__attribute__((unused)) const char *ctx) {}
+
+#define ZEMU_LOGF(SIZE, ...) {}
+
+__Z_INLINE void strncpy_s(char *dst, const char *src, size_t dstSize) {
+    MEMZERO(dst, dstSize);
+    if (dstSize > 0) {
+        strncpy(dst, src, dstSize - 1);
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
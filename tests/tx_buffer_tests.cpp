@@ -0,0 +1,166 @@
+/*******************************************************************************
+*   (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include <gtest/gtest.h>
+#include <vector>
+#include "utils/multisend.h"
+#include "utils/testcases.h"
+#include "tx_buffer.h"
+#include "parser_impl.h"
+#include "zxmacros.h"
+
+namespace {
+    // APDU payload
+    const size_t CHUNK_SIZE = 250;
+
+    std::vector<uint8_t> flash(32768);
+
+    uint32_t announcedLength(const std::string &tx) {
+        return (uint32_t) ((tx.size() + CHUNK_SIZE - 1) / CHUNK_SIZE * 255);
+    }
+}
+
+class TxBufferTests : public ::testing::Test {
+protected:
+    void SetUp() override {
+        tx_buffer_init(flash.data(), (uint32_t) flash.size());
+        nvm_stats = {};
+    }
+
+    void TearDown() override {
+        // other tests parse their own buffers, with the whole arena for the tokens
+        tx_buffer_init(nullptr, 0);
+    }
+
+    // The tx shows the same items whether it is kept in RAM or in flash
+    static void expectSameUI(const std::string &tx) {
+        parser_context_t ctx;
+        ASSERT_EQ(utils::uploadTx(&ctx, tx, false, CHUNK_SIZE, announcedLength(tx)), parser_ok);
+        const auto uploaded = utils::dumpUI(&ctx, 40, 40);
+
+        tx_buffer_reset(0);
+        ASSERT_EQ(utils::parseTx(&ctx, tx, false), parser_ok);
+        EXPECT_EQ(uploaded, utils::dumpUI(&ctx, 40, 40));
+    }
+};
+
+TEST_F(TxBufferTests, CorpusStaysInRam) {
+    for (const auto &name : utils::testcaseNames()) {
+        const std::string tx = utils::loadTestcase(name);
+        expectSameUI(tx);
+
+        parser_context_t ctx;
+        ASSERT_EQ(utils::uploadTx(&ctx, tx, false, CHUNK_SIZE, announcedLength(tx)), parser_ok) << name;
+        EXPECT_FALSE(tx_buffer_in_flash()) << name;
+        EXPECT_EQ(std::string((const char *) tx_buffer_data(), tx_buffer_length()), tx) << name;
+    }
+    EXPECT_EQ(nvm_stats.writes, 0u);
+}
+
+// Beyond TX_BUFFER_RAM_SIZE, as long as the tokens leave room for it
+TEST_F(TxBufferTests, LargeTxStaysInRam) {
+    const std::string tx = utils::multisendTx(100);
+    ASSERT_GT(tx.size(), (size_t) TX_BUFFER_RAM_SIZE);
+
+    expectSameUI(tx);
+    parser_context_t ctx;
+    ASSERT_EQ(utils::uploadTx(&ctx, tx, false, CHUNK_SIZE, announcedLength(tx)), parser_ok);
+    EXPECT_FALSE(tx_buffer_in_flash());
+    EXPECT_EQ(nvm_stats.writes, 0u);
+}
+
+// The tx fits in the arena, but its tokens need its RAM
+TEST_F(TxBufferTests, TokensMoveTxToFlash) {
+    const std::string tx = utils::multisendTx(160);
+    ASSERT_LT(announcedLength(tx), (uint32_t) TX_BUFFER_ARENA_SIZE);
+
+    expectSameUI(tx);
+    nvm_stats = {};
+    parser_context_t ctx;
+    ASSERT_EQ(utils::uploadTx(&ctx, tx, false, CHUNK_SIZE, announcedLength(tx)), parser_ok);
+    EXPECT_TRUE(tx_buffer_in_flash());
+    EXPECT_EQ(std::string((const char *) tx_buffer_data(), tx_buffer_length()), tx);
+    // the part received in RAM is written once, then every chunk
+    EXPECT_EQ(nvm_stats.bytes, tx.size());
+}
+
+// The tx is kept in RAM as long as it leaves room for MAX_NUMBER_OF_TOKENS, then it is moved at once
+TEST_F(TxBufferTests, TooLargeForRam) {
+    const std::string tx = utils::multisendTx(200);
+    ASSERT_GT(tx.size(), (size_t) TX_BUFFER_ARENA_SIZE - MAX_NUMBER_OF_TOKENS * sizeof(jsmntok_t));
+
+    parser_context_t ctx;
+    ASSERT_EQ(utils::uploadTx(&ctx, tx, false, CHUNK_SIZE, UINT16_MAX), parser_ok);
+    EXPECT_TRUE(tx_buffer_in_flash());
+    EXPECT_EQ(nvm_stats.bytes, tx.size());
+    // the RAM content at once, then one write per chunk
+    const size_t chunksInRam = TX_BUFFER_RAM_SIZE / CHUNK_SIZE;
+    EXPECT_LE(nvm_stats.writes, 1 + (tx.size() + CHUNK_SIZE - 1) / CHUNK_SIZE - chunksInRam);
+}
+
+// Beyond MAX_NUMBER_OF_TOKENS, the msgs elements are tokenized when they are shown
+TEST_F(TxBufferTests, TooManyTokensWindowed) {
+    const uint16_t numMsgs = 140;
+    const std::string tx = utils::delegateTx(numMsgs);
+
+    parser_context_t ctx;
+    ASSERT_EQ(utils::uploadTx(&ctx, tx, false, CHUNK_SIZE, announcedLength(tx)), parser_ok);
+    ASSERT_TRUE(parser_tx_obj.json.window != nullptr);
+    EXPECT_GT(parser_tx_obj.json.numberOfTokens, (uint32_t) MAX_NUMBER_OF_TOKENS);
+    EXPECT_LT(json_tokens_in_use(&parser_tx_obj.json), parser_tx_obj.json.numberOfTokens / 10);
+
+    uint16_t numItems = 0;
+    ASSERT_EQ(parser_getNumItems(&ctx, &numItems), parser_ok);
+    EXPECT_EQ(numItems, utils::delegateNumItems(numMsgs));
+    const auto ui = utils::dumpUI(&ctx, 40, 40);
+    ASSERT_FALSE(ui.empty());
+    EXPECT_EQ(ui.back().rfind(std::to_string(numItems - 1) + " |", 0), 0u) << ui.back();
+}
+
+TEST_F(TxBufferTests, MoreDataThanAnnounced) {
+    const std::string tx = utils::multisendTx(10);
+
+    parser_context_t ctx;
+    ASSERT_EQ(utils::uploadTx(&ctx, tx, false, CHUNK_SIZE, 1000), parser_ok);
+    EXPECT_TRUE(tx_buffer_in_flash());
+    EXPECT_EQ(std::string((const char *) tx_buffer_data(), tx_buffer_length()), tx);
+}
+
+TEST_F(TxBufferTests, TooLargeForFlash) {
+    tx_buffer_init(flash.data(), 100);
+    tx_buffer_reset(100);
+
+    const uint8_t chunk[CHUNK_SIZE] = {};
+    EXPECT_EQ(tx_buffer_append(chunk, sizeof(chunk)), 0u);
+    EXPECT_EQ(tx_buffer_length(), 0u);
+}
+
+// The tokens, the display table and the tx kept in RAM are reported once the display table is built
+TEST_F(TxBufferTests, Watermark) {
+    tx_buffer_watermark_reset();
+    const std::string tx = utils::multisendTx(100);
+
+    parser_context_t ctx;
+    ASSERT_EQ(utils::uploadTx(&ctx, tx, false, CHUNK_SIZE, announcedLength(tx)), parser_ok);
+    ASSERT_EQ(parser_validate(&ctx), parser_ok);
+    utils::dumpUI(&ctx, 40, 40);
+
+    // the tx and its tokens at least
+    EXPECT_GT(tx_buffer_watermark(), tx.size() + parser_tx_obj.json.numberOfTokens * sizeof(jsmntok_t));
+    EXPECT_LE(tx_buffer_watermark(), (size_t) TX_BUFFER_ARENA_SIZE);
+
+    tx_buffer_watermark_reset();
+    EXPECT_EQ(tx_buffer_watermark(), 0u);
+}
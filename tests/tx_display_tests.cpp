@@ -0,0 +1,339 @@
+/*******************************************************************************
+*   (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <map>
+#include <vector>
+#include "utils/multisend.h"
+#include "utils/testcases.h"
+#include "app_mode.h"
+#include "tx_display.h"
+
+namespace {
+    // Every item from the display table must match the search by traversal
+    void expectTableMatchesTraversal(const std::string &tx, bool expert) {
+        parser_context_t ctx;
+        ASSERT_EQ(utils::parseTx(&ctx, tx, expert), parser_ok);
+
+        uint16_t numItems = 0;
+        ASSERT_EQ(tx_display_numItems(&numItems), parser_ok);
+        ASSERT_GT(numItems, 0);
+
+        for (uint16_t idx = 0; idx < numItems; idx++) {
+            char tableKey[100];
+            char findKey[100];
+            uint16_t tableToken = 0;
+            uint16_t findToken = 0;
+            key_id_e tableKeyId = key_unknown;
+            key_id_e findKeyId = key_unknown;
+
+            ASSERT_EQ(tx_display_query(idx, tableKey, sizeof(tableKey), &tableToken, &tableKeyId), parser_ok) << idx;
+            ASSERT_EQ(tx_display_find(idx, findKey, sizeof(findKey), &findToken, &findKeyId), parser_ok) << idx;
+            EXPECT_STREQ(tableKey, findKey) << idx;
+            EXPECT_EQ(tableToken, findToken) << idx;
+            EXPECT_EQ(tableKeyId, findKeyId) << idx;
+        }
+
+        char key[100];
+        uint16_t token;
+        key_id_e keyId;
+        EXPECT_EQ(tx_display_query(numItems, key, sizeof(key), &token, &keyId), parser_display_idx_out_of_range);
+    }
+
+    // The cursor must find the same items as the search by traversal, in whatever order they are requested
+    void expectCursorMatchesTraversal(const std::string &tx, bool expert) {
+        parser_context_t ctx;
+        ASSERT_EQ(utils::parseTx(&ctx, tx, expert), parser_ok);
+
+        uint16_t numItems = 0;
+        ASSERT_EQ(tx_display_numItems(&numItems), parser_ok);
+        ASSERT_GT(numItems, 0);
+
+        std::vector<uint16_t> order;
+        // forward, asking each item twice as when moving through its pages
+        for (uint16_t idx = 0; idx < numItems; idx++) {
+            order.push_back(idx);
+            order.push_back(idx);
+        }
+        // backward
+        for (uint16_t idx = numItems; idx > 0; idx--) {
+            order.push_back(idx - 1);
+        }
+        // random access
+        for (uint16_t i = 0; i < numItems; i++) {
+            order.push_back((i * 7) % numItems);
+        }
+
+        for (const uint16_t idx : order) {
+            char cursorKey[100];
+            char findKey[100];
+            uint16_t cursorToken = 0;
+            uint16_t findToken = 0;
+            key_id_e cursorKeyId = key_unknown;
+            key_id_e findKeyId = key_unknown;
+
+            ASSERT_EQ(tx_display_cursor_query(idx, cursorKey, sizeof(cursorKey), &cursorToken, &cursorKeyId),
+                      parser_ok) << idx;
+            ASSERT_EQ(tx_display_find(idx, findKey, sizeof(findKey), &findToken, &findKeyId), parser_ok) << idx;
+            EXPECT_STREQ(cursorKey, findKey) << idx;
+            EXPECT_EQ(cursorToken, findToken) << idx;
+            EXPECT_EQ(cursorKeyId, findKeyId) << idx;
+        }
+
+        char key[100];
+        uint16_t token;
+        key_id_e keyId;
+        EXPECT_EQ(tx_display_cursor_query(numItems, key, sizeof(key), &token, &keyId),
+                  parser_display_idx_out_of_range);
+    }
+
+    // The validation walk must return every item once, in display order
+    void expectWalkMatchesTraversal(const std::string &tx, bool expert) {
+        parser_context_t ctx;
+        ASSERT_EQ(utils::parseTx(&ctx, tx, expert), parser_ok);
+
+        uint16_t numItems = 0;
+        ASSERT_EQ(tx_display_walk_start(&numItems), parser_ok);
+        ASSERT_GT(numItems, 0);
+
+        for (uint16_t idx = 0; idx < numItems; idx++) {
+            char findKey[100];
+            uint16_t walkToken = 0;
+            uint16_t findToken = 0;
+            key_id_e walkKeyId = key_unknown;
+            key_id_e findKeyId = key_unknown;
+
+            ASSERT_EQ(tx_display_walk_next(&walkToken, &walkKeyId), parser_ok) << idx;
+            ASSERT_EQ(tx_display_find(idx, findKey, sizeof(findKey), &findToken, &findKeyId), parser_ok) << idx;
+            EXPECT_EQ(walkToken, findToken) << idx;
+            EXPECT_EQ(walkKeyId, findKeyId) << idx;
+        }
+    }
+
+    // Key of every known path, as it was matched before paths were tracked by id
+    const std::map<key_id_e, std::string> KNOWN_PATHS = {
+            {key_chain_id,                     "chain_id"},
+            {key_account_number,               "account_number"},
+            {key_sequence,                     "sequence"},
+            {key_memo,                         "memo"},
+            {key_msgs,                         "msgs"},
+            {key_source,                       "source"},
+            {key_data,                         "data"},
+            {key_msgs_type,                    "msgs/type"},
+            {key_msgs_value,                   "msgs/value"},
+            {key_msgs_value_amount,            "msgs/value/amount"},
+            {key_msgs_value_delegator_address, "msgs/value/delegator_address"},
+            {key_msgs_value_inputs,            "msgs/value/inputs"},
+            {key_msgs_value_inputs_coins,      "msgs/value/inputs/coins"},
+            {key_msgs_value_outputs,           "msgs/value/outputs"},
+            {key_msgs_value_outputs_coins,     "msgs/value/outputs/coins"},
+            {key_msgs_inputs,                  "msgs/inputs"},
+            {key_msgs_inputs_address,          "msgs/inputs/address"},
+            {key_msgs_inputs_coins,            "msgs/inputs/coins"},
+            {key_msgs_outputs,                 "msgs/outputs"},
+            {key_msgs_outputs_address,         "msgs/outputs/address"},
+            {key_msgs_outputs_coins,           "msgs/outputs/coins"},
+            {key_msgs_voting_period,           "msgs/voting_period"},
+            {key_msgs_refid,                   "msgs/refid"},
+            {key_msgs_timeinforce,             "msgs/timeinforce"},
+            {key_msgs_ordertype,               "msgs/ordertype"},
+            {key_msgs_id,                      "msgs/id"},
+            {key_msgs_side,                    "msgs/side"},
+            {key_msgs_price,                   "msgs/price"},
+            {key_msgs_quantity,                "msgs/quantity"},
+            {key_msgs_sender,                  "msgs/sender"},
+            {key_msgs_symbol,                  "msgs/symbol"},
+    };
+
+    // The known path of every item must be the one its key spells
+    void expectKnownPaths(const std::string &tx, bool expert) {
+        parser_context_t ctx;
+        ASSERT_EQ(utils::parseTx(&ctx, tx, expert), parser_ok);
+
+        uint16_t numItems = 0;
+        ASSERT_EQ(tx_display_numItems(&numItems), parser_ok);
+
+        for (uint16_t idx = 0; idx < numItems; idx++) {
+            char key[100];
+            uint16_t token = 0;
+            key_id_e keyId = key_unknown;
+            ASSERT_EQ(tx_display_query(idx, key, sizeof(key), &token, &keyId), parser_ok) << idx;
+
+            if (keyId != key_unknown) {
+                EXPECT_EQ(KNOWN_PATHS.at(keyId), key) << idx;
+                continue;
+            }
+            for (const auto &known : KNOWN_PATHS) {
+                EXPECT_NE(known.second, key) << idx;
+            }
+        }
+    }
+}
+
+TEST(TxDisplay, TableMatchesTraversal) {
+    for (const auto &name : utils::testcaseNames()) {
+        SCOPED_TRACE(name);
+        const std::string tx = utils::loadTestcase(name);
+        expectTableMatchesTraversal(tx, false);
+        expectTableMatchesTraversal(tx, true);
+    }
+}
+
+TEST(TxDisplay, TableMatchesTraversalMultisend) {
+    for (const uint16_t numOutputs : {1, 10, 60}) {
+        SCOPED_TRACE(numOutputs);
+        expectTableMatchesTraversal(utils::multisendTx(numOutputs, 3), false);
+    }
+}
+
+TEST(TxDisplay, GroupedMsgs) {
+    for (const uint16_t numMsgs : {1, 2, 50, 100}) {
+        SCOPED_TRACE(numMsgs);
+        const std::string tx = utils::delegateTx(numMsgs);
+        parser_context_t ctx;
+        ASSERT_EQ(utils::parseTx(&ctx, tx, false), parser_ok);
+
+        uint16_t numItems = 0;
+        ASSERT_EQ(tx_display_numItems(&numItems), parser_ok);
+        EXPECT_EQ(numItems, utils::delegateNumItems(numMsgs));
+        expectTableMatchesTraversal(tx, false);
+    }
+}
+
+// Re-tokenizing the msgs elements on demand shows the same items
+// The root items are found by tx_validate
+TEST(TxDisplay, RequiresValidation) {
+    const std::string tx = utils::loadTestcase("send");
+    parser_context_t ctx;
+    ASSERT_EQ(parser_parse(&ctx, (const uint8_t *) tx.c_str(), tx.size()), parser_ok);
+
+    uint16_t numItems = 0;
+    EXPECT_EQ(tx_display_numItems(&numItems), parser_unexpected_error);
+
+    ASSERT_EQ(parser_validate(&ctx), parser_ok);
+    EXPECT_EQ(tx_display_numItems(&numItems), parser_ok);
+    EXPECT_GT(numItems, 0);
+}
+
+TEST(TxDisplay, WindowedMatchesFull) {
+    std::vector<std::string> txs;
+    for (const auto &name : utils::testcaseNames()) {
+        txs.push_back(utils::loadTestcase(name));
+    }
+    txs.push_back(utils::delegateTx(100));
+    txs.push_back(utils::multisendTx(20, 2));
+
+    for (const auto &tx : txs) {
+        for (const bool expert : {false, true}) {
+            parser_context_t ctx;
+            ASSERT_EQ(utils::parseTx(&ctx, tx, expert), parser_ok);
+            const auto full = utils::dumpUI(&ctx, 40, 40);
+
+            ASSERT_EQ(utils::parseTxWindowed(&ctx, tx, expert), parser_ok) << tx;
+            EXPECT_TRUE(parser_tx_obj.json.window != nullptr);
+            EXPECT_EQ(utils::dumpUI(&ctx, 40, 40), full) << tx;
+        }
+    }
+}
+
+TEST(TxDisplay, CursorMatchesTraversal) {
+    for (const auto &name : utils::testcaseNames()) {
+        SCOPED_TRACE(name);
+        const std::string tx = utils::loadTestcase(name);
+        expectCursorMatchesTraversal(tx, false);
+        expectCursorMatchesTraversal(tx, true);
+    }
+}
+
+TEST(TxDisplay, CursorMatchesTraversalMultisend) {
+    for (const uint16_t numOutputs : {1, 10, 60}) {
+        SCOPED_TRACE(numOutputs);
+        expectCursorMatchesTraversal(utils::multisendTx(numOutputs, 3), false);
+        expectCursorMatchesTraversal(utils::multisendTx(numOutputs, 3), true);
+    }
+}
+
+TEST(TxDisplay, ExpertModeChange) {
+    const std::string tx = utils::loadTestcase("send");
+
+    parser_context_t ctx;
+    ASSERT_EQ(utils::parseTx(&ctx, tx, true), parser_ok);
+    const auto expertUI = utils::dumpUI(&ctx, 40, 40);
+    ASSERT_EQ(utils::parseTx(&ctx, tx, false), parser_ok);
+    const auto normalUI = utils::dumpUI(&ctx, 40, 40);
+    ASSERT_NE(expertUI, normalUI);
+
+    // switching mode without parsing again
+    app_mode_set_expert(true);
+    EXPECT_EQ(utils::dumpUI(&ctx, 40, 40), expertUI);
+    app_mode_set_expert(false);
+    EXPECT_EQ(utils::dumpUI(&ctx, 40, 40), normalUI);
+}
+
+TEST(TxDisplay, WalkMatchesTraversal) {
+    for (const auto &name : utils::testcaseNames()) {
+        SCOPED_TRACE(name);
+        const std::string tx = utils::loadTestcase(name);
+        expectWalkMatchesTraversal(tx, false);
+        expectWalkMatchesTraversal(tx, true);
+    }
+    expectWalkMatchesTraversal(utils::multisendTx(60, 3), false);
+}
+
+TEST(TxDisplay, KnownKeyPaths) {
+    for (const auto &name : utils::testcaseNames()) {
+        SCOPED_TRACE(name);
+        const std::string tx = utils::loadTestcase(name);
+        expectKnownPaths(tx, false);
+        expectKnownPaths(tx, true);
+    }
+}
+
+TEST(TxDisplay, KnownKeyLookup) {
+    for (const auto &known : KNOWN_PATHS) {
+        SCOPED_TRACE(known.second);
+        const std::string &path = known.second;
+
+        key_id_e keyId = key_root;
+        size_t start = 0;
+        while (start <= path.size()) {
+            const size_t end = std::min(path.find('/', start), path.size());
+            keyId = known_key_find(keyId, path.c_str() + start, (uint16_t) (end - start));
+            start = end + 1;
+        }
+        EXPECT_EQ(keyId, known.first);
+    }
+
+    // the same names in other places, prefixes and extensions
+    EXPECT_EQ(known_key_find(key_root, "type", 4), key_unknown);
+    EXPECT_EQ(known_key_find(key_msgs, "memo", 4), key_unknown);
+    EXPECT_EQ(known_key_find(key_msgs_inputs, "amount", 6), key_unknown);
+    EXPECT_EQ(known_key_find(key_msgs, "typ", 3), key_unknown);
+    EXPECT_EQ(known_key_find(key_msgs, "types", 5), key_unknown);
+    EXPECT_EQ(known_key_find(key_msgs, "", 0), key_unknown);
+    EXPECT_EQ(known_key_find(key_unknown, "msgs", 4), key_unknown);
+
+    EXPECT_STREQ(known_key_label(key_chain_id), "Chain ID");
+    EXPECT_STREQ(known_key_label(key_msgs_outputs_coins), "Send output coins");
+    EXPECT_EQ(known_key_label(key_msgs_type), nullptr);
+    EXPECT_EQ(known_key_label(key_unknown), nullptr);
+
+    EXPECT_STREQ(known_key_value_label(key_msgs_ordertype, "2"), "Limit order");
+    EXPECT_STREQ(known_key_value_label(key_msgs_timeinforce, "3"), "Immediate or Cancel");
+    EXPECT_EQ(known_key_value_label(key_msgs_timeinforce, "2"), nullptr);
+    EXPECT_EQ(known_key_value_label(key_msgs_side, "11"), nullptr);
+    EXPECT_EQ(known_key_value_label(key_msgs_price, "1"), nullptr);
+}
@@ -0,0 +1,176 @@
+/*******************************************************************************
+*   (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include <gtest/gtest.h>
+#include <string>
+#include "utils/testcases.h"
+#include "tx_display.h"
+#include "tx_parser.h"
+
+// The iterative tx_traverse_find must find the same items as the recursive engine it replaced
+// (kept below as the reference), for every root item and item index of the corpus, which includes
+// the transactions of the zemu snapshots (sign_basic, sign_max_depth, ...).
+
+namespace {
+    // depth limit of the recursive engine
+    constexpr uint8_t RECURSION_DEPTH = 6;
+    // keys longer than this are truncated
+    constexpr uint16_t SHORT_KEY_LEN = 12;
+
+    // Previous recursive engine (with the known path of the key passed down)
+    parser_error_t referenceTraverseFind(uint16_t root_token_index, key_id_e key_id, uint16_t *ret_value_token_index) {
+        const jsmntype_t token_type = (jsmntype_t) parser_tx_obj.json.tokens[root_token_index].type;
+
+        if (parser_tx_obj.query.max_level <= 0 || parser_tx_obj.query.max_depth <= 0 ||
+            token_type == JSMN_STRING ||
+            token_type == JSMN_PRIMITIVE) {
+            const bool skipField = tx_is_grouped_field(key_id, parser_tx_obj.query._item_index_current);
+
+            if (!skipField && parser_tx_obj.query._item_index_current == parser_tx_obj.query.item_index) {
+                *ret_value_token_index = root_token_index;
+                parser_tx_obj.query.out_key_id = key_id;
+                return parser_ok;
+            }
+
+            if (skipField) {
+                parser_tx_obj.query.item_index++;
+            }
+
+            parser_tx_obj.query._item_index_current++;
+            return parser_query_no_results;
+        }
+
+        const uint16_t end_token_index = json_next_sibling(&parser_tx_obj.json, root_token_index);
+        parser_error_t err;
+
+        switch (token_type) {
+            case JSMN_OBJECT: {
+                const size_t key_len = strlen(parser_tx_obj.query.out_key);
+                for (uint16_t key_index = json_first_child(&parser_tx_obj.json, root_token_index);
+                     key_index + 1 < end_token_index;
+                     key_index = json_next_sibling(&parser_tx_obj.json, key_index + 1)) {
+                    tx_append_key_item(key_index);
+
+                    parser_tx_obj.query.max_level--;
+                    parser_tx_obj.query.max_depth--;
+                    err = referenceTraverseFind(key_index + 1, tx_key_child(key_id, key_index), ret_value_token_index);
+                    parser_tx_obj.query.max_level++;
+                    parser_tx_obj.query.max_depth++;
+
+                    if (err == parser_ok) {
+                        return parser_ok;
+                    }
+
+                    *(parser_tx_obj.query.out_key + key_len) = 0;
+                }
+                break;
+            }
+            case JSMN_ARRAY: {
+                for (uint16_t element_index = json_first_child(&parser_tx_obj.json, root_token_index);
+                     element_index < end_token_index;
+                     element_index = json_next_sibling(&parser_tx_obj.json, element_index)) {
+                    parser_tx_obj.query.max_depth--;
+                    err = referenceTraverseFind(element_index, key_id, ret_value_token_index);
+                    parser_tx_obj.query.max_depth++;
+
+                    if (err == parser_ok) {
+                        return parser_ok;
+                    }
+                }
+                break;
+            }
+            default:
+                break;
+        }
+
+        return parser_query_no_results;
+    }
+
+    struct FindResult {
+        parser_error_t err;
+        uint16_t token;
+        std::string key;
+        uint8_t key_id;
+        int16_t item_index;
+        uint16_t item_index_current;
+    };
+
+    FindResult find(bool reference, uint16_t root_token, const char *rootName,
+                    uint8_t maxLevel, uint8_t maxDepth, uint16_t keyLen, int16_t itemIdx) {
+        char key[100];
+        char val[2];
+        INIT_QUERY_CONTEXT(key, keyLen, val, sizeof(val), 0, maxLevel)
+        parser_tx_obj.query.max_depth = maxDepth;
+        parser_tx_obj.query.item_index = itemIdx;
+        strncpy_s(key, rootName, keyLen);
+
+        FindResult r{};
+        r.err = reference ? referenceTraverseFind(root_token, tx_key_child(key_root, root_token - 1), &r.token)
+                          : tx_traverse_find(root_token, &r.token);
+        r.key = key;
+        r.key_id = parser_tx_obj.query.out_key_id;
+        r.item_index = parser_tx_obj.query.item_index;
+        r.item_index_current = parser_tx_obj.query._item_index_current;
+        if (r.err != parser_ok) {
+            r.token = 0;
+            r.key_id = key_unknown;
+        }
+        return r;
+    }
+
+    void expectSameItems(const std::string &tx, bool expert, uint8_t maxDepth, uint16_t keyLen) {
+        parser_context_t ctx;
+        ASSERT_EQ(utils::parseTx(&ctx, tx, expert), parser_ok);
+
+        for (int root = root_item_chain_id; root <= root_item_data; root++) {
+            const char *rootName = get_required_root_item((root_item_e) root);
+            const uint8_t maxLevel = root == root_item_msgs ? 2 : 1;
+
+            uint16_t rootToken;
+            if (object_get_value(&parser_tx_obj.json, ROOT_TOKEN_INDEX, rootName, &rootToken) != parser_ok) {
+                continue;
+            }
+
+            for (int16_t itemIdx = 0;; itemIdx++) {
+                SCOPED_TRACE(std::string(rootName) + " #" + std::to_string(itemIdx));
+                const FindResult expected = find(true, rootToken, rootName, maxLevel, maxDepth, keyLen, itemIdx);
+                const FindResult actual = find(false, rootToken, rootName, maxLevel, maxDepth, keyLen, itemIdx);
+
+                EXPECT_EQ(actual.err, expected.err);
+                EXPECT_EQ(actual.token, expected.token);
+                EXPECT_EQ(actual.key, expected.key);
+                EXPECT_EQ(actual.key_id, expected.key_id);
+                EXPECT_EQ(actual.item_index, expected.item_index);
+                EXPECT_EQ(actual.item_index_current, expected.item_index_current);
+
+                if (expected.err != parser_ok) {
+                    break;
+                }
+            }
+        }
+    }
+}
+
+TEST(TxTraverse, SameItemsAsRecursiveEngine) {
+    for (const auto &name : utils::testcaseNames()) {
+        SCOPED_TRACE(name);
+        const std::string tx = utils::loadTestcase(name);
+        for (const uint8_t maxDepth : {RECURSION_DEPTH, (uint8_t) MAX_TRAVERSAL_DEPTH}) {
+            expectSameItems(tx, false, maxDepth, 100);
+            expectSameItems(tx, true, maxDepth, 100);
+        }
+        expectSameItems(tx, false, MAX_TRAVERSAL_DEPTH, SHORT_KEY_LEN);
+    }
+}
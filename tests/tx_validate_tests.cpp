@@ -0,0 +1,96 @@
+/*******************************************************************************
+*   (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include <gtest/gtest.h>
+#include <string>
+#include "tx_validate.h"
+#include "tx_display.h"
+
+namespace {
+    parsed_json_t json;
+    jsmntok_t tokens[MAX_NUMBER_OF_TOKENS];
+    tx_root_slots_t slots;
+
+    std::string txWithMsg(const std::string &msg) {
+        return R"({"account_number":"1","chain_id":"Binance-Chain-Tigris","data":"DATA","memo":"MEMO","msgs":[)" +
+               msg + R"(],"sequence":"2","source":"1"})";
+    }
+
+    parser_error_t validate(const std::string &tx) {
+        const parser_error_t err = json_parse(&json, tokens, MAX_NUMBER_OF_TOKENS, tx.c_str(), tx.size());
+        if (err != parser_ok) {
+            return err;
+        }
+        return tx_validate(&json, &slots);
+    }
+}
+
+TEST(TxValidate, LongKeys) {
+    const std::string longKey(300, 'k');
+
+    EXPECT_EQ(validate(txWithMsg(R"({")" + longKey + R"(":"1",")" + longKey + R"(z":"2"})")), parser_ok);
+    EXPECT_EQ(validate(txWithMsg(R"({")" + longKey + R"(z":"1",")" + longKey + R"(":"2"})")),
+              parser_json_is_not_sorted);
+    EXPECT_EQ(validate(txWithMsg(R"({")" + longKey + R"(":"1",")" + longKey + R"(":"2"})")),
+              parser_duplicated_field);
+}
+
+TEST(TxValidate, KeyPrefixOrder) {
+    // as strcmp: a key sorts after its own prefix
+    EXPECT_EQ(validate(txWithMsg(R"({"a":"1","ab":"2"})")), parser_ok);
+    EXPECT_EQ(validate(txWithMsg(R"({"ab":"1","a":"2"})")), parser_json_is_not_sorted);
+}
+
+TEST(TxValidate, WhitespaceBeforeOrder) {
+    // whitespace is reported even if it comes after an unsorted object
+    EXPECT_EQ(validate(txWithMsg(R"({"b":"1","a":"2"},{"a": "1"})")), parser_json_contains_whitespace);
+}
+
+TEST(TxValidate, WhitespaceInStrings) {
+    EXPECT_EQ(validate(txWithMsg(R"({"a":"b c"})")), parser_ok);
+}
+
+TEST(TxValidate, RootSlots) {
+    // json points into the tx
+    const std::string tx = txWithMsg(R"({"a":"1"})");
+    ASSERT_EQ(validate(tx), parser_ok);
+    EXPECT_TRUE(slots.valid);
+    EXPECT_TRUE(slots.is_default_chain);
+    for (uint8_t root = 0; root < NUM_REQUIRED_ROOT_PAGES; root++) {
+        const char *rootName = get_required_root_item((root_item_e) root);
+        uint16_t token_index = 0;
+        ASSERT_EQ(object_get_value(&json, ROOT_TOKEN_INDEX, rootName, &token_index), parser_ok) << rootName;
+        EXPECT_EQ(slots.value_token[root], token_index) << rootName;
+    }
+
+    const std::string otherChain = R"({"account_number":"1","chain_id":"Binance-Chain-Tigris2","data":"D","memo":"M",)"
+                                   R"("msgs":[],"sequence":"2","source":"1"})";
+    ASSERT_EQ(validate(otherChain), parser_ok);
+    EXPECT_FALSE(slots.is_default_chain);
+
+    // the first missing field is reported, in the same order as before
+    EXPECT_EQ(validate(R"({"account_number":"1","data":"D","memo":"M","msgs":[],"source":"1"})"),
+              parser_json_missing_chain_id);
+    EXPECT_EQ(validate(R"({"chain_id":"C","data":"D","memo":"M","msgs":[],"sequence":"2"})"),
+              parser_json_missing_account_number);
+    EXPECT_EQ(validate(R"({"account_number":"1","chain_id":"C","data":"D","memo":"M","msgs":[],"sequence":"2"})"),
+              parser_json_missing_data);
+    EXPECT_FALSE(slots.valid);
+
+    // the root fields are only known once the root keys are known to be sorted
+    EXPECT_EQ(validate(R"({"chain_id":"C","account_number":"1","data":"D","memo":"M","msgs":[],"sequence":"2","source":"1"})"),
+              parser_json_is_not_sorted);
+    EXPECT_FALSE(slots.valid);
+}
@@ -0,0 +1,294 @@
+/*******************************************************************************
+*   (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <tuple>
+#include <vector>
+#include "utils/multisend.h"
+#include "utils/testcases.h"
+
+// Each tests/testcases/<name>.json is rendered in normal and expert mode and compared
+// against tests/testcases/expected/<name>[.expert].ui
+// Set UPDATE_EXPECTED=1 to regenerate the expected output.
+
+struct UITestcase {
+    std::string name;
+    bool expert;
+};
+
+class UITests : public ::testing::TestWithParam<UITestcase> {
+public:
+    struct PrintToStringParamName {
+        std::string operator()(const ::testing::TestParamInfo<UITestcase> &info) const {
+            return info.param.name + (info.param.expert ? "_expert" : "");
+        }
+    };
+};
+
+std::vector<UITestcase> GetUITestcases() {
+    std::vector<UITestcase> answer;
+    for (const auto &name : utils::testcaseNames()) {
+        answer.push_back({name, false});
+        answer.push_back({name, true});
+    }
+    return answer;
+}
+
+INSTANTIATE_TEST_SUITE_P(
+        Corpus,
+        UITests,
+        ::testing::ValuesIn(GetUITestcases()),
+        UITests::PrintToStringParamName()
+);
+
+TEST_P(UITests, Render) {
+    const auto tc = GetParam();
+    const std::string tx = utils::loadTestcase(tc.name);
+
+    parser_context_t ctx;
+    ASSERT_EQ(utils::parseTx(&ctx, tx, tc.expert), parser_ok);
+
+    const auto ui = utils::dumpUI(&ctx, 40, 40);
+    ASSERT_FALSE(ui.empty());
+
+    std::stringstream rendered;
+    for (const auto &line : ui) {
+        rendered << line << "\n";
+    }
+
+    const std::string expectedPath = std::string(TESTVECTORS_DIR) + "expected/" +
+                                     tc.name + (tc.expert ? ".expert" : "") + ".ui";
+
+    if (std::getenv("UPDATE_EXPECTED") != nullptr) {
+        std::ofstream out(expectedPath, std::ios::binary);
+        out << rendered.str();
+    }
+
+    EXPECT_EQ(rendered.str(), utils::readFile(expectedPath));
+}
+
+TEST_P(UITests, RenderChunked) {
+    const auto tc = GetParam();
+    const std::string tx = utils::loadTestcase(tc.name);
+
+    parser_context_t ctx;
+    ASSERT_EQ(utils::parseTx(&ctx, tx, tc.expert), parser_ok);
+    const auto expected = utils::dumpUI(&ctx, 40, 40);
+
+    // 250 bytes is the APDU payload, small sizes cut every token at some point
+    for (const size_t chunkSize : {1, 2, 7, 250}) {
+        ASSERT_EQ(utils::parseTxChunked(&ctx, tx, tc.expert, chunkSize), parser_ok) << chunkSize;
+        EXPECT_EQ(utils::dumpUI(&ctx, 40, 40), expected) << chunkSize;
+    }
+}
+
+// Pages are shown the same whatever order they are requested in (amount pages are cached)
+TEST_P(UITests, PagesInAnyOrder) {
+    const auto tc = GetParam();
+    const std::string tx = utils::loadTestcase(tc.name);
+
+    parser_context_t ctx;
+    ASSERT_EQ(utils::parseTx(&ctx, tx, tc.expert), parser_ok);
+
+    uint16_t numItems = 0;
+    ASSERT_EQ(parser_getNumItems(&ctx, &numItems), parser_ok);
+
+    // small values so that coins take several pages
+    char outKey[40];
+    char outVal[12];
+    std::vector<std::vector<std::string>> pages(numItems);
+    for (uint16_t idx = 0; idx < numItems; idx++) {
+        uint8_t pageCount = 1;
+        for (uint8_t pageIdx = 0; pageIdx < pageCount; pageIdx++) {
+            ASSERT_EQ(parser_getItem(&ctx, idx, outKey, sizeof(outKey), outVal, sizeof(outVal), pageIdx, &pageCount),
+                      parser_ok);
+            pages[idx].emplace_back(outVal);
+        }
+    }
+
+    for (uint16_t idx = numItems; idx > 0; idx--) {
+        const auto &expected = pages[idx - 1];
+        for (uint8_t pageIdx = expected.size(); pageIdx > 0; pageIdx--) {
+            uint8_t pageCount = 0;
+            ASSERT_EQ(parser_getItem(&ctx, idx - 1, outKey, sizeof(outKey), outVal, sizeof(outVal),
+                                     pageIdx - 1, &pageCount), parser_ok);
+            EXPECT_EQ(pageCount, expected.size());
+            EXPECT_EQ(std::string(outVal), expected[pageIdx - 1]) << (int) idx - 1 << "/" << (int) pageIdx - 1;
+        }
+    }
+}
+
+TEST(UITests, IndexOutOfRange) {
+    const std::string tx = utils::loadTestcase("send");
+
+    parser_context_t ctx;
+    ASSERT_EQ(utils::parseTx(&ctx, tx, false), parser_ok);
+
+    uint16_t numItems = 0;
+    ASSERT_EQ(parser_getNumItems(&ctx, &numItems), parser_ok);
+
+    char outKey[40];
+    char outVal[40];
+    uint8_t pageCount;
+    EXPECT_EQ(parser_getItem(&ctx, numItems, outKey, sizeof(outKey), outVal, sizeof(outVal), 0, &pageCount),
+              parser_display_idx_out_of_range);
+}
+
+// Past the last page of a coins list, with the pages cached and with more coins than the cache holds
+TEST(UITests, AmountPageOutOfRange) {
+    for (const uint16_t numDenoms : {2, 40}) {
+        const std::string tx = utils::multisendTx(1, numDenoms);
+        parser_context_t ctx;
+        ASSERT_EQ(utils::parseTx(&ctx, tx, false), parser_ok) << numDenoms;
+
+        // 0: input address, 1: input coins
+        char outKey[40];
+        char outVal[40];
+        uint8_t pageCount = 0;
+        ASSERT_EQ(parser_getItem(&ctx, 1, outKey, sizeof(outKey), outVal, sizeof(outVal), 0, &pageCount), parser_ok);
+        ASSERT_EQ(pageCount, numDenoms);
+        EXPECT_EQ(parser_getItem(&ctx, 1, outKey, sizeof(outKey), outVal, sizeof(outVal), pageCount, &pageCount),
+                  parser_display_page_out_of_range) << numDenoms;
+    }
+}
+
+struct InvalidTestcase {
+    std::string name;
+    std::string tx;
+    parser_error_t expected;
+};
+
+class InvalidTxTests : public ::testing::TestWithParam<InvalidTestcase> {
+public:
+    struct PrintToStringParamName {
+        std::string operator()(const ::testing::TestParamInfo<InvalidTestcase> &info) const {
+            return info.param.name;
+        }
+    };
+};
+
+INSTANTIATE_TEST_SUITE_P(
+        Validation,
+        InvalidTxTests,
+        ::testing::Values(
+                InvalidTestcase{"whitespace",
+                                R"({ "account_number":"1","chain_id":"Binance-Chain-Tigris","data":"DATA","memo":"MEMO","msgs":[{"a":"b"}],"sequence":"2","source":"1"})",
+                                parser_json_contains_whitespace},
+                InvalidTestcase{"whitespace_trailing",
+                                R"({"account_number":"1","chain_id":"Binance-Chain-Tigris","data":"DATA","memo":"MEMO","msgs":[{"a":"b"}],"sequence":"2","source":"1" })",
+                                parser_json_contains_whitespace},
+                InvalidTestcase{"whitespace_nested",
+                                R"({"account_number":"1","chain_id":"Binance-Chain-Tigris","data":"DATA","memo":"MEMO","msgs":[{ "a":"b"}],"sequence":"2","source":"1"})",
+                                parser_json_contains_whitespace},
+                InvalidTestcase{"whitespace_after_primitive",
+                                R"({"account_number":"1","chain_id":"Binance-Chain-Tigris","data":"DATA","memo":"MEMO","msgs":[{"a":1 }],"sequence":"2","source":"1"})",
+                                parser_json_contains_whitespace},
+                InvalidTestcase{"duplicated_key",
+                                R"({"account_number":"1","chain_id":"Binance-Chain-Tigris","data":"DATA","memo":"MEMO","msgs":[{"a":"1","a":"2"}],"sequence":"2","source":"1"})",
+                                parser_duplicated_field},
+                InvalidTestcase{"unsorted_root",
+                                R"({"chain_id":"Binance-Chain-Tigris","account_number":"1","data":"DATA","memo":"MEMO","msgs":[{"a":"b"}],"sequence":"2","source":"1"})",
+                                parser_json_is_not_sorted},
+                InvalidTestcase{"unsorted_nested",
+                                R"({"account_number":"1","chain_id":"Binance-Chain-Tigris","data":"DATA","memo":"MEMO","msgs":[{"b":"1","a":"2"}],"sequence":"2","source":"1"})",
+                                parser_json_is_not_sorted},
+                InvalidTestcase{"missing_chain_id",
+                                R"({"account_number":"1","data":"DATA","memo":"MEMO","msgs":[{"a":"b"}],"sequence":"2","source":"1"})",
+                                parser_json_missing_chain_id},
+                InvalidTestcase{"missing_sequence",
+                                R"({"account_number":"1","chain_id":"Binance-Chain-Tigris","data":"DATA","memo":"MEMO","msgs":[{"a":"b"}],"source":"1"})",
+                                parser_json_missing_sequence},
+                InvalidTestcase{"missing_msgs",
+                                R"({"account_number":"1","chain_id":"Binance-Chain-Tigris","data":"DATA","memo":"MEMO","sequence":"2","source":"1"})",
+                                parser_json_missing_msgs},
+                InvalidTestcase{"missing_account_number",
+                                R"({"chain_id":"Binance-Chain-Tigris","data":"DATA","memo":"MEMO","msgs":[{"a":"b"}],"sequence":"2","source":"1"})",
+                                parser_json_missing_account_number},
+                InvalidTestcase{"missing_memo",
+                                R"({"account_number":"1","chain_id":"Binance-Chain-Tigris","data":"DATA","msgs":[{"a":"b"}],"sequence":"2","source":"1"})",
+                                parser_json_missing_memo},
+                InvalidTestcase{"missing_data",
+                                R"({"account_number":"1","chain_id":"Binance-Chain-Tigris","memo":"MEMO","msgs":[{"a":"b"}],"sequence":"2","source":"1"})",
+                                parser_json_missing_data},
+                InvalidTestcase{"missing_source",
+                                R"({"account_number":"1","chain_id":"Binance-Chain-Tigris","data":"DATA","memo":"MEMO","msgs":[{"a":"b"}],"sequence":"2"})",
+                                parser_json_missing_data},
+                InvalidTestcase{"incomplete",
+                                R"({"account_number":"1","chain_id":"Binance-Chain-Tigris","data":"DATA")",
+                                parser_json_incomplete_json}
+        ),
+        InvalidTxTests::PrintToStringParamName()
+);
+
+TEST_P(InvalidTxTests, Rejected) {
+    const auto tc = GetParam();
+
+    parser_context_t ctx;
+    EXPECT_EQ(utils::parseTx(&ctx, tc.tx, false), tc.expected);
+    EXPECT_EQ(utils::parseTxChunked(&ctx, tc.tx, false, 7), tc.expected);
+}
+
+std::string sendTx(const std::string &amount) {
+    return R"({"account_number":"34","chain_id":"Binance-Chain-Tigris","data":null,"memo":"","msgs":[{"inputs":[{"address":"bnb1grpf0955h0ykzq3ar5nmum7y6gdfl6lxfn46h2","coins":[{"amount":)" +
+           amount +
+           R"(,"denom":"BNB"}]}],"outputs":[{"address":"bnb1jxfh2g85q3v0tdq56fnevx6xcxtcnhtsmcu64m","coins":[{"amount":)" +
+           amount +
+           R"(,"denom":"BNB"}]}]}],"sequence":"31","source":"1"})";
+}
+
+TEST(UITests, AmountFormat) {
+    const std::vector<std::tuple<std::string, bool, std::string>> cases = {
+            {"0",                    false, "0.00000000 BNB"},
+            {"1",                    false, "0.00000001 BNB"},
+            {"99999999",             false, "0.99999999 BNB"},
+            {"100000000",            false, "1.00000000 BNB"},
+            {"000123",               false, "0.00000123 BNB"},
+            {"18446744073709551615", false, "184467440737.09551615 BNB"},
+            {"000123",               true,  "000123 BNB"},
+            {"18446744073709551616", true,  "18446744073709551616 BNB"},
+    };
+
+    for (const auto &c : cases) {
+        const auto &amount = std::get<0>(c);
+        parser_context_t ctx;
+        ASSERT_EQ(utils::parseTx(&ctx, sendTx(amount), std::get<1>(c)), parser_ok) << amount;
+
+        const auto ui = utils::dumpUI(&ctx, 40, 40);
+        const auto line = std::find_if(ui.begin(), ui.end(), [](const std::string &l) {
+            return l.find("Send input coins") != std::string::npos;
+        });
+        ASSERT_NE(line, ui.end()) << amount;
+        EXPECT_EQ(line->substr(line->find(" : ") + 3), std::get<2>(c)) << amount;
+    }
+}
+
+TEST(UITests, AmountRejected) {
+    parser_context_t ctx;
+    EXPECT_EQ(utils::parseTx(&ctx, sendTx("18446744073709551616"), false), parser_value_out_of_range);
+    EXPECT_EQ(utils::parseTx(&ctx, sendTx(R"("1.5")"), false), parser_unexpected_characters);
+    EXPECT_EQ(utils::parseTx(&ctx, sendTx("-1"), false), parser_unexpected_characters);
+}
+
+// Page counts are uint8_t, values with more pages are rejected instead of being cut
+TEST(UITests, TooManyPages) {
+    // parser_validate shows the first page of every item with 39 characters per page
+    parser_context_t ctx;
+    EXPECT_EQ(utils::parseTx(&ctx, utils::memoTx(39 * 255), false), parser_ok);
+    EXPECT_EQ(utils::parseTx(&ctx, utils::memoTx(39 * 255 + 1), false), parser_display_too_many_pages);
+}
@@ -0,0 +1,98 @@
+/*******************************************************************************
+*   (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include "utils/multisend.h"
+
+#include <sstream>
+#include <vector>
+
+namespace utils {
+
+    namespace {
+        const char BECH32_CHARSET[] = "qpzry9x8gf2tvdw0s3jn54khce6mua7l";
+        const char *DENOMS[] = {"BNB", "BUSD-BD1", "BTCB-1DE", "ETH-1C9", "USDT-6D8", "XRP-BF2", "ADA-9F4", "CAKE-435"};
+        constexpr uint16_t NUM_DENOMS = sizeof(DENOMS) / sizeof(DENOMS[0]);
+
+        std::string coins(uint64_t amount, uint16_t numDenoms) {
+            std::stringstream ss;
+            ss << "[";
+            for (uint16_t i = 0; i < numDenoms; i++) {
+                if (i > 0) {
+                    ss << ",";
+                }
+                ss << R"({"amount":)" << amount * (i + 1) << R"(,"denom":")" << DENOMS[i % NUM_DENOMS] << R"("})";
+            }
+            ss << "]";
+            return ss.str();
+        }
+    }
+
+    std::string fakeAddress(const std::string &hrp, uint32_t index) {
+        std::string addr = hrp + "1";
+        uint32_t state = 0x9E3779B9u ^ (index * 0x85EBCA6Bu);
+        for (int i = 0; i < 38; i++) {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            addr += BECH32_CHARSET[state % 32];
+        }
+        return addr;
+    }
+
+    std::string multisendTx(uint16_t numOutputs, uint16_t numDenoms) {
+        const uint64_t amount = 100000000;
+
+        std::stringstream ss;
+        ss << R"({"account_number":"34","chain_id":"Binance-Chain-Tigris","data":null,"memo":"",)";
+        ss << R"("msgs":[{"inputs":[{"address":")" << fakeAddress("bnb", 0) << R"(","coins":)"
+           << coins(amount * numOutputs, numDenoms) << "}],";
+        ss << R"("outputs":[)";
+        for (uint16_t i = 0; i < numOutputs; i++) {
+            if (i > 0) {
+                ss << ",";
+            }
+            ss << R"({"address":")" << fakeAddress("bnb", i + 1) << R"(","coins":)"
+               << coins(amount, numDenoms) << "}";
+        }
+        ss << R"(]}],"sequence":"31","source":"1"})";
+        return ss.str();
+    }
+
+    uint32_t multisendNumItems(uint16_t numOutputs) {
+        // address + coins for the input and each output
+        return 2u * (1u + numOutputs);
+    }
+
+    std::string delegateTx(uint16_t numMsgs) {
+        std::stringstream ss;
+        ss << R"({"account_number":"7","chain_id":"Binance-Chain-Tigris","data":null,"memo":"","msgs":[)";
+        for (uint16_t i = 0; i < numMsgs; i++) {
+            if (i > 0) {
+                ss << ",";
+            }
+            ss << R"({"type":"cosmos-sdk/MsgDelegate","value":{"amount":{"amount":")" << 100000000u * (i + 1)
+               << R"(","denom":"BNB"},"delegator_address":")" << fakeAddress("bnb", 0)
+               << R"(","validator_address":")" << fakeAddress("bva", i + 1) << R"("}})";
+        }
+        ss << R"(],"sequence":"9","source":"0"})";
+        return ss.str();
+    }
+
+    uint32_t delegateNumItems(uint16_t numMsgs) {
+        // type and delegator are shown once, then amount + validator for each msg
+        return 2u + 2u * numMsgs;
+    }
+
+}
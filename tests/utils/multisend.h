@@ -0,0 +1,39 @@
+/*******************************************************************************
+*   (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace utils {
+
+    /// Canonical (sorted keys, no whitespace) multisend transaction.
+    /// The single input carries the sum of all outputs, every input/output holds numDenoms coins.
+    std::string multisendTx(uint16_t numOutputs, uint16_t numDenoms = 1);
+
+    /// Number of review items expected for multisendTx() in normal mode
+    uint32_t multisendNumItems(uint16_t numOutputs);
+
+    /// Canonical transaction with numMsgs delegations from the same address, so type and delegator are grouped
+    std::string delegateTx(uint16_t numMsgs);
+
+    /// Number of review items expected for delegateTx() in normal mode
+    uint32_t delegateNumItems(uint16_t numMsgs);
+
+    /// Deterministic bech32-looking address for the given index
+    std::string fakeAddress(const std::string &hrp, uint32_t index);
+
+}
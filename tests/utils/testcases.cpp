@@ -0,0 +1,187 @@
+/*******************************************************************************
+*   (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include "utils/testcases.h"
+
+#include <algorithm>
+#include <dirent.h>
+#include <fstream>
+#include <sstream>
+#include "app_mode.h"
+#include "tx_buffer.h"
+
+namespace utils {
+
+    std::vector<std::string> testcaseNames() {
+        std::vector<std::string> names;
+
+        DIR *dir = opendir(TESTVECTORS_DIR);
+        if (dir == nullptr) {
+            return names;
+        }
+
+        const std::string ext = ".json";
+        for (struct dirent *entry = readdir(dir); entry != nullptr; entry = readdir(dir)) {
+            const std::string fileName = entry->d_name;
+            if (fileName.size() > ext.size() &&
+                fileName.compare(fileName.size() - ext.size(), ext.size(), ext) == 0) {
+                names.push_back(fileName.substr(0, fileName.size() - ext.size()));
+            }
+        }
+        closedir(dir);
+
+        std::sort(names.begin(), names.end());
+        return names;
+    }
+
+    std::string readFile(const std::string &path) {
+        std::ifstream file(path, std::ios::binary);
+        std::stringstream ss;
+        ss << file.rdbuf();
+        return ss.str();
+    }
+
+    std::string loadTestcase(const std::string &name) {
+        std::string tx = readFile(std::string(TESTVECTORS_DIR) + name + ".json");
+        while (!tx.empty() && (tx.back() == '\n' || tx.back() == '\r')) {
+            tx.pop_back();
+        }
+        return tx;
+    }
+
+    std::string memoTx(size_t memoLen) {
+        std::string tx = loadTestcase("send");
+        const std::string emptyMemo = R"("memo":"")";
+        tx.replace(tx.find(emptyMemo), emptyMemo.size(), R"("memo":")" + std::string(memoLen, 'x') + "\"");
+        return tx;
+    }
+
+    parser_error_t parseTx(parser_context_t *ctx, const std::string &tx, bool expertMode) {
+        app_mode_set_expert(expertMode);
+
+        parser_error_t err = parser_parse(ctx, (const uint8_t *) tx.c_str(), tx.size());
+        if (err != parser_ok) {
+            return err;
+        }
+
+        return parser_validate(ctx);
+    }
+
+    parser_error_t parseTxWindowed(parser_context_t *ctx, const std::string &tx, bool expertMode) {
+        app_mode_set_expert(expertMode);
+
+        parser_error_t err = parser_parse_windowed(ctx, (const uint8_t *) tx.c_str(), tx.size());
+        if (err != parser_ok) {
+            return err;
+        }
+
+        return parser_validate(ctx);
+    }
+
+    parser_error_t parseTxChunked(parser_context_t *ctx, const std::string &tx, bool expertMode, size_t chunkSize) {
+        app_mode_set_expert(expertMode);
+
+        parser_parse_init(ctx);
+        for (size_t received = chunkSize; received < tx.size(); received += chunkSize) {
+            // the tx is complete only after the last chunk, so errors are reported by parser_parse_finish
+            parser_parse_chunk(ctx, (const uint8_t *) tx.c_str(), received);
+        }
+
+        parser_error_t err = parser_parse_finish(ctx, (const uint8_t *) tx.c_str(), tx.size());
+        if (err != parser_ok) {
+            return err;
+        }
+
+        return parser_validate(ctx);
+    }
+
+    parser_error_t uploadTx(parser_context_t *ctx, const std::string &tx, bool expertMode, size_t chunkSize,
+                            uint32_t maxLength) {
+        app_mode_set_expert(expertMode);
+
+        tx_buffer_reset(maxLength);
+        parser_parse_init(ctx);
+        for (size_t offset = 0; offset < tx.size(); offset += chunkSize) {
+            const auto length = (uint32_t) std::min(chunkSize, tx.size() - offset);
+            if (tx_buffer_append((const uint8_t *) tx.c_str() + offset, length) != length) {
+                return parser_unexpected_buffer_end;
+            }
+
+            // the tokens may need the RAM of the tx, it is moved to flash then
+            if (parser_parse_chunk(ctx, tx_buffer_data(), tx_buffer_length()) == parser_json_too_many_tokens &&
+                tx_buffer_move_to_flash()) {
+                parser_parse_chunk(ctx, tx_buffer_data(), tx_buffer_length());
+            }
+        }
+
+        parser_error_t err = parser_parse_finish(ctx, tx_buffer_data(), tx_buffer_length());
+        if (err == parser_json_too_many_tokens && tx_buffer_move_to_flash()) {
+            err = parser_parse_finish(ctx, tx_buffer_data(), tx_buffer_length());
+        }
+        if (err == parser_json_too_many_tokens) {
+            err = parser_parse_windowed(ctx, tx_buffer_data(), tx_buffer_length());
+        }
+        if (err != parser_ok) {
+            return err;
+        }
+
+        return parser_validate(ctx);
+    }
+
+    std::vector<std::string> dumpUI(const parser_context_t *ctx, uint16_t outKeyLen, uint16_t outValLen) {
+        std::vector<std::string> answer;
+
+        uint16_t numItems;
+        if (parser_getNumItems(ctx, &numItems) != parser_ok) {
+            return answer;
+        }
+
+        std::vector<char> outKey(outKeyLen);
+        std::vector<char> outVal(outValLen);
+
+        for (uint16_t idx = 0; idx < numItems; idx++) {
+            uint8_t pageCount = 1;
+            for (uint8_t pageIdx = 0; pageIdx < pageCount; pageIdx++) {
+                std::stringstream ss;
+
+                parser_error_t err = parser_getItem(ctx, idx,
+                                                    outKey.data(), outKeyLen,
+                                                    outVal.data(), outValLen,
+                                                    pageIdx, &pageCount);
+
+                ss << idx << " | " << outKey.data();
+                if (pageCount > 1) {
+                    ss << " [" << (int) pageIdx + 1 << "/" << (int) pageCount << "]";
+                }
+                ss << " : ";
+
+                if (err == parser_ok) {
+                    ss << outVal.data();
+                } else {
+                    ss << parser_getErrorDescription(err);
+                }
+
+                answer.push_back(ss.str());
+
+                if (err != parser_ok) {
+                    break;
+                }
+            }
+        }
+
+        return answer;
+    }
+
+}
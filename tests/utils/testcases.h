@@ -0,0 +1,52 @@
+/*******************************************************************************
+*   (c) 2018 - 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#pragma once
+
+#include <string>
+#include <vector>
+#include "common/parser.h"
+
+namespace utils {
+
+    /// Names (without extension) of the transactions in tests/testcases
+    std::vector<std::string> testcaseNames();
+
+    /// Raw json of a transaction in tests/testcases
+    std::string loadTestcase(const std::string &name);
+
+    std::string readFile(const std::string &path);
+
+    /// The "send" testcase with a memo of memoLen characters
+    std::string memoTx(size_t memoLen);
+
+    /// Parses and validates a transaction with the given expert mode setting
+    parser_error_t parseTx(parser_context_t *ctx, const std::string &tx, bool expertMode);
+
+    /// Same as parseTx, but only the skeleton of the msgs elements is tokenized (see json_parse_windowed)
+    parser_error_t parseTxWindowed(parser_context_t *ctx, const std::string &tx, bool expertMode);
+
+    /// Same as parseTx, but tokenizes while the tx arrives in chunks of chunkSize bytes (as tx_append does)
+    parser_error_t parseTxChunked(parser_context_t *ctx, const std::string &tx, bool expertMode, size_t chunkSize);
+
+    /// Same as parseTxChunked, but the tx is kept in the tx buffer as tx_append and tx_parse do (src/common/tx.c).
+    /// maxLength is the size announced for the tx
+    parser_error_t uploadTx(parser_context_t *ctx, const std::string &tx, bool expertMode, size_t chunkSize,
+                            uint32_t maxLength);
+
+    /// Renders every item and page as "idx | key [page/count] : value"
+    std::vector<std::string> dumpUI(const parser_context_t *ctx, uint16_t outKeyLen, uint16_t outValLen);
+
+}